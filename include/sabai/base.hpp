@@ -2,9 +2,23 @@
 
 #include <cstdint>
 #include <exception>
+#include <type_traits>
+
+// Element access through operator() is bounds checked unless
+// SABAI_BOUNDS_CHECK is 0, which is its default when NDEBUG is defined.
+// at() is always checked.
+#ifndef SABAI_BOUNDS_CHECK
+#ifdef NDEBUG
+#define SABAI_BOUNDS_CHECK 0
+#else
+#define SABAI_BOUNDS_CHECK 1
+#endif
+#endif
 
 namespace sabai {
 
+inline constexpr bool bounds_checked = SABAI_BOUNDS_CHECK != 0;
+
 template <typename T, typename U> struct is_same {
   static const bool value = false;
 };
@@ -25,4 +39,62 @@ public:
     return "index invalid for size";
   }
 };
+
+class MismatchedLength : public std::exception {
+private:
+  size_t left_length_;
+  size_t right_length_;
+
+public:
+  MismatchedLength(size_t left_length, size_t right_length)
+      : left_length_(left_length), right_length_(right_length) {}
+
+  ~MismatchedLength() override{};
+
+  const char *what() const noexcept override { return "mismatched lengths"; }
+};
+
+// Specialized by every array and view type with its ValueType, its NumDims
+// and the owning ArrayType that holds results computed from it.
+template <typename Array> struct array_traits {
+  static constexpr size_t NumDims = static_cast<size_t>(0);
+};
+
+template <typename Array>
+concept ArrayLike =
+    array_traits<std::remove_cvref_t<Array>>::NumDims > static_cast<size_t>(0);
+
+template <typename Array>
+concept VectorLike =
+    array_traits<std::remove_cvref_t<Array>>::NumDims == static_cast<size_t>(1);
+
+template <typename Array>
+using ValueTypeOf =
+    typename array_traits<std::remove_cvref_t<Array>>::ValueType;
+
+// True for the lazy elementwise expressions built by the arithmetic
+// operators, which are evaluated only when assigned to an array.
+template <typename Array> struct is_expression {
+  static constexpr bool value = false;
+};
+
+template <ArrayLike Left, ArrayLike Right>
+requires(array_traits<Left>::NumDims ==
+         array_traits<Right>::NumDims) constexpr bool
+all_equal(const Left &left, const Right &right) {
+  if (left.length() != right.length()) {
+    throw MismatchedLength(left.length(), right.length());
+  }
+
+  for (size_t index = static_cast<size_t>(0); index < left.length(); ++index) {
+    if constexpr (array_traits<Left>::NumDims == static_cast<size_t>(1)) {
+      if (left(index) != right(index)) {
+        return false;
+      }
+    } else if (!all_equal(left(index), right(index))) {
+      return false;
+    }
+  }
+  return true;
+}
 } // namespace sabai
\ No newline at end of file
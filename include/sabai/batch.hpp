@@ -0,0 +1,397 @@
+#pragma once
+
+#include "sabai/base.hpp"
+#include "sabai/dynamic.hpp"
+#include "sabai/simd.hpp"
+#include "sabai/static.hpp"
+
+namespace sabai {
+
+template <typename Array> class Batch;
+
+// Many StaticArrays of one shape, stored structure-of-arrays: component c of
+// every element is contiguous, so the batched kernels below work on one
+// element per SIMD lane and vectorize across the batch however small the
+// arrays are.
+template <typename T, size_t... Shape> class Batch<StaticArray<T, Shape...>> {
+public:
+  using Element = StaticArray<T, Shape...>;
+  static constexpr size_t components = (Shape * ...);
+
+private:
+  // One row per component, one column per element.
+  DynamicArray<T, 2> data_;
+
+  template <typename... Indices>
+  static constexpr size_t component(Indices... indices) {
+    const size_t shape[] = {Shape...};
+    const size_t values[] = {static_cast<size_t>(indices)...};
+    size_t result = static_cast<size_t>(0);
+    for (size_t dim = static_cast<size_t>(0); dim < sizeof...(Shape); ++dim) {
+      if constexpr (bounds_checked) {
+        if (values[dim] >= shape[dim]) {
+          throw OutOfRange(values[dim], shape[dim]);
+        }
+      }
+      result = result * shape[dim] + values[dim];
+    }
+    return result;
+  }
+
+public:
+  explicit Batch(size_t size) : data_(components, size) {}
+
+  size_t size() const { return data_.shape(1); }
+
+  // Every element's value of one component.
+  template <typename... Indices>
+  requires(sizeof...(Indices) == sizeof...(Shape)) DynamicArrayView<T, 1>
+  operator()(Indices... indices) {
+    return data_.view()(component(indices...));
+  }
+
+  template <typename... Indices>
+  requires(sizeof...(Indices) == sizeof...(Shape)) DynamicArrayView<const T, 1>
+  operator()(Indices... indices) const {
+    return data_.view()(component(indices...));
+  }
+
+  // The contiguous values of component c, the flattened row-major index of
+  // a component.
+  T *data(size_t c) { return data_.data() + c * size(); }
+
+  const T *data(size_t c) const { return data_.data() + c * size(); }
+
+  Element get(size_t index) const {
+    if (index >= size()) {
+      throw OutOfRange(index, size());
+    }
+    Element element;
+    for (size_t c = static_cast<size_t>(0); c < components; ++c) {
+      element.data()[c] = data(c)[index];
+    }
+    return element;
+  }
+
+  void set(size_t index, const Element &element) {
+    if (index >= size()) {
+      throw OutOfRange(index, size());
+    }
+    for (size_t c = static_cast<size_t>(0); c < components; ++c) {
+      data(c)[index] = element.data()[c];
+    }
+  }
+};
+
+template <typename Left, typename Right>
+void check_batch_sizes(const Left &left, const Right &right) {
+  if (left.size() != right.size()) {
+    throw MismatchedLength(left.size(), right.size());
+  }
+}
+
+// Loads the components of one register's worth of elements into values.
+template <typename Pack, typename T>
+void load_batch(const T *data, size_t size, size_t index, size_t count,
+                typename Pack::Type *values) {
+  for (size_t c = static_cast<size_t>(0); c < count; ++c) {
+    values[c] = Pack::load(data + c * size + index);
+  }
+}
+
+template <typename Pack, typename T>
+void store_batch(T *data, size_t size, size_t index, size_t count,
+                 const typename Pack::Type *values) {
+  for (size_t c = static_cast<size_t>(0); c < count; ++c) {
+    Pack::store(data + c * size + index, values[c]);
+  }
+}
+
+template <typename T, size_t M, size_t N, size_t P>
+Batch<StaticArray<T, M, P>> operator*(const Batch<StaticArray<T, M, N>> &A,
+                                      const Batch<StaticArray<T, N, P>> &B) {
+  check_batch_sizes(A, B);
+  const size_t size = A.size();
+  Batch<StaticArray<T, M, P>> C(size);
+  const T *a = A.data(0);
+  const T *b = B.data(0);
+  T *c = C.data(0);
+  simd_batch<T>(size, [=]<typename Pack>(size_t index) {
+    typename Pack::Type left[M * N];
+    typename Pack::Type right[N * P];
+    typename Pack::Type result[M * P];
+    load_batch<Pack>(a, size, index, M * N, left);
+    load_batch<Pack>(b, size, index, N * P, right);
+    for (size_t i = static_cast<size_t>(0); i < M; ++i) {
+      for (size_t j = static_cast<size_t>(0); j < P; ++j) {
+        typename Pack::Type sum = left[i * N] * right[j];
+        for (size_t k = static_cast<size_t>(1); k < N; ++k) {
+          sum += left[i * N + k] * right[k * P + j];
+        }
+        result[i * P + j] = sum;
+      }
+    }
+    store_batch<Pack>(c, size, index, M * P, result);
+  });
+  return C;
+}
+
+template <typename T, size_t M, size_t N>
+Batch<StaticArray<T, M>> operator*(const Batch<StaticArray<T, M, N>> &A,
+                                   const Batch<StaticArray<T, N>> &x) {
+  check_batch_sizes(A, x);
+  const size_t size = A.size();
+  Batch<StaticArray<T, M>> y(size);
+  const T *a = A.data(0);
+  const T *b = x.data(0);
+  T *c = y.data(0);
+  simd_batch<T>(size, [=]<typename Pack>(size_t index) {
+    typename Pack::Type matrix[M * N];
+    typename Pack::Type vector[N];
+    typename Pack::Type result[M];
+    load_batch<Pack>(a, size, index, M * N, matrix);
+    load_batch<Pack>(b, size, index, N, vector);
+    for (size_t i = static_cast<size_t>(0); i < M; ++i) {
+      typename Pack::Type sum = matrix[i * N] * vector[0];
+      for (size_t k = static_cast<size_t>(1); k < N; ++k) {
+        sum += matrix[i * N + k] * vector[k];
+      }
+      result[i] = sum;
+    }
+    store_batch<Pack>(c, size, index, M, result);
+  });
+  return y;
+}
+
+template <typename T, size_t N>
+DynamicVector<T> dot(const Batch<StaticArray<T, N>> &left,
+                     const Batch<StaticArray<T, N>> &right) {
+  check_batch_sizes(left, right);
+  const size_t size = left.size();
+  DynamicVector<T> result(size);
+  const T *a = left.data(0);
+  const T *b = right.data(0);
+  T *c = result.data();
+  simd_batch<T>(size, [=]<typename Pack>(size_t index) {
+    typename Pack::Type sum = Pack::load(a + index) * Pack::load(b + index);
+    for (size_t k = static_cast<size_t>(1); k < N; ++k) {
+      const size_t offset = k * size + index;
+      sum += Pack::load(a + offset) * Pack::load(b + offset);
+    }
+    Pack::store(c + index, sum);
+  });
+  return result;
+}
+
+template <typename T, size_t N>
+DynamicVector<T> norm(const Batch<StaticArray<T, N>> &vectors) {
+  const size_t size = vectors.size();
+  DynamicVector<T> result(size);
+  const T *a = vectors.data(0);
+  T *c = result.data();
+  simd_batch<T>(size, [=]<typename Pack>(size_t index) {
+    typename Pack::Type sum = {};
+    for (size_t k = static_cast<size_t>(0); k < N; ++k) {
+      const typename Pack::Type value = Pack::load(a + k * size + index);
+      sum += value * value;
+    }
+    Pack::sqrt(sum);
+    Pack::store(c + index, sum);
+  });
+  return result;
+}
+
+template <typename T>
+Batch<StaticArray<T, 3>> cross(const Batch<StaticArray<T, 3>> &left,
+                               const Batch<StaticArray<T, 3>> &right) {
+  check_batch_sizes(left, right);
+  const size_t size = left.size();
+  Batch<StaticArray<T, 3>> result(size);
+  const T *a = left.data(0);
+  const T *b = right.data(0);
+  T *c = result.data(0);
+  simd_batch<T>(size, [=]<typename Pack>(size_t index) {
+    typename Pack::Type l[3];
+    typename Pack::Type r[3];
+    load_batch<Pack>(a, size, index, 3, l);
+    load_batch<Pack>(b, size, index, 3, r);
+    const typename Pack::Type product[3] = {l[1] * r[2] - l[2] * r[1],
+                                            l[2] * r[0] - l[0] * r[2],
+                                            l[0] * r[1] - l[1] * r[0]};
+    store_batch<Pack>(c, size, index, 3, product);
+  });
+  return result;
+}
+
+// CholeskyDecomposition of every element of a batch: the upper triangular
+// U with A = U^T U, below which cholesky holds zeros.
+template <typename T, size_t N> struct BatchCholeskyDecomposition {
+  Batch<StaticArray<T, N, N>> cholesky;
+
+  BatchCholeskyDecomposition(const Batch<StaticArray<T, N, N>> &A)
+      : cholesky(A.size()) {
+    const size_t size = A.size();
+    const T *a = A.data(0);
+    T *u = cholesky.data(0);
+    simd_batch<T>(size, [=]<typename Pack>(size_t index) {
+      typename Pack::Type values[N * N];
+      load_batch<Pack>(a, size, index, N * N, values);
+      for (size_t i = static_cast<size_t>(0); i < N; ++i) {
+        for (size_t j = static_cast<size_t>(0); j < i; ++j) {
+          values[i * N + j] = typename Pack::Type{};
+        }
+        for (size_t k = static_cast<size_t>(0); k < i; ++k) {
+          for (size_t j = i; j < N; ++j) {
+            values[i * N + j] -= values[k * N + i] * values[k * N + j];
+          }
+        }
+        Pack::sqrt(values[i * N + i]);
+        const typename Pack::Type diagonal = values[i * N + i];
+        for (size_t j = i + static_cast<size_t>(1); j < N; ++j) {
+          values[i * N + j] /= diagonal;
+        }
+      }
+      store_batch<Pack>(u, size, index, N * N, values);
+    });
+  }
+};
+
+// LUDecomposition of every element of a batch of square matrices, packed:
+// factors holds the unit lower triangular L below the diagonal and U on and
+// above it, and row i of L U is row P(i) of A. Every lane pivots on its own
+// element, selecting rows with masks rather than branches.
+template <typename T, size_t N> struct BatchLUDecomposition {
+  Batch<StaticArray<T, N, N>> factors;
+  Batch<StaticArray<size_t, N>> P;
+
+  BatchLUDecomposition(const Batch<StaticArray<T, N, N>> &A)
+      : factors(A.size()), P(A.size()) {
+    const size_t size = A.size();
+    const T *a = A.data(0);
+    T *lu = factors.data(0);
+    size_t *p = P.data(0);
+    simd_batch<T>(size, [=]<typename Pack>(size_t index) {
+      using Type = typename Pack::Type;
+      const Type zero = {};
+      Type values[N * N];
+      // Row numbers are tracked as T so that they share the lanes' masks.
+      Type rows[N];
+      load_batch<Pack>(a, size, index, N * N, values);
+      for (size_t i = static_cast<size_t>(0); i < N; ++i) {
+        rows[i] = zero + static_cast<T>(i);
+      }
+      for (size_t k = static_cast<size_t>(0); k < N; ++k) {
+        Type pivot = zero + static_cast<T>(k);
+        Type max_value = values[k * N + k];
+        max_value = max_value < zero ? -max_value : max_value;
+        for (size_t row = k + static_cast<size_t>(1); row < N; ++row) {
+          Type value = values[row * N + k];
+          value = value < zero ? -value : value;
+          const auto larger = value > max_value;
+          pivot = larger ? zero + static_cast<T>(row) : pivot;
+          max_value = larger ? value : max_value;
+        }
+        for (size_t row = k + static_cast<size_t>(1); row < N; ++row) {
+          const auto swapped = pivot == zero + static_cast<T>(row);
+          for (size_t j = static_cast<size_t>(0); j < N; ++j) {
+            const Type first = values[k * N + j];
+            values[k * N + j] = swapped ? values[row * N + j] : first;
+            values[row * N + j] = swapped ? first : values[row * N + j];
+          }
+          const Type first = rows[k];
+          rows[k] = swapped ? rows[row] : first;
+          rows[row] = swapped ? first : rows[row];
+        }
+        // A zero pivot leaves the column below it, which is zero too, alone.
+        const Type diagonal = values[k * N + k];
+        const auto nonzero = diagonal != zero;
+        for (size_t row = k + static_cast<size_t>(1); row < N; ++row) {
+          const Type factor =
+              nonzero ? values[row * N + k] / diagonal : zero;
+          values[row * N + k] = factor;
+          for (size_t j = k + static_cast<size_t>(1); j < N; ++j) {
+            values[row * N + j] -= factor * values[k * N + j];
+          }
+        }
+      }
+      store_batch<Pack>(lu, size, index, N * N, values);
+      for (size_t i = static_cast<size_t>(0); i < N; ++i) {
+        T lanes[Pack::width];
+        Pack::store(lanes, rows[i]);
+        for (size_t lane = static_cast<size_t>(0); lane < Pack::width;
+             ++lane) {
+          p[i * size + index + lane] = static_cast<size_t>(lanes[lane]);
+        }
+      }
+    });
+  }
+};
+
+template <typename T, size_t N>
+Batch<StaticArray<T, N>>
+solve(const BatchCholeskyDecomposition<T, N> &cholesky_decomp,
+      const Batch<StaticArray<T, N>> &b) {
+  check_batch_sizes(cholesky_decomp.cholesky, b);
+  const size_t size = b.size();
+  Batch<StaticArray<T, N>> x(size);
+  const T *u = cholesky_decomp.cholesky.data(0);
+  const T *y = b.data(0);
+  T *result = x.data(0);
+  simd_batch<T>(size, [=]<typename Pack>(size_t index) {
+    typename Pack::Type values[N];
+    load_batch<Pack>(y, size, index, N, values);
+    // U^T z = b, then U x = z.
+    for (size_t i = static_cast<size_t>(0); i < N; ++i) {
+      for (size_t k = static_cast<size_t>(0); k < i; ++k) {
+        values[i] -= Pack::load(u + (k * N + i) * size + index) * values[k];
+      }
+      values[i] /= Pack::load(u + (i * N + i) * size + index);
+    }
+    for (size_t i = N; i-- > static_cast<size_t>(0);) {
+      for (size_t k = i + static_cast<size_t>(1); k < N; ++k) {
+        values[i] -= Pack::load(u + (i * N + k) * size + index) * values[k];
+      }
+      values[i] /= Pack::load(u + (i * N + i) * size + index);
+    }
+    store_batch<Pack>(result, size, index, N, values);
+  });
+  return x;
+}
+
+template <typename T, size_t N>
+Batch<StaticArray<T, N>> solve(const BatchLUDecomposition<T, N> &lu_decomp,
+                               const Batch<StaticArray<T, N>> &b) {
+  check_batch_sizes(lu_decomp.factors, b);
+  const size_t size = b.size();
+  Batch<StaticArray<T, N>> x(size);
+  const T *lu = lu_decomp.factors.data(0);
+  const size_t *p = lu_decomp.P.data(0);
+  const T *y = b.data(0);
+  T *result = x.data(0);
+  simd_batch<T>(size, [=]<typename Pack>(size_t index) {
+    typename Pack::Type values[N];
+    // Gathers b(P(i)) lane by lane, then L z = P b and U x = z.
+    for (size_t i = static_cast<size_t>(0); i < N; ++i) {
+      T lanes[Pack::width];
+      for (size_t lane = static_cast<size_t>(0); lane < Pack::width; ++lane) {
+        const size_t element = index + lane;
+        lanes[lane] = y[p[i * size + element] * size + element];
+      }
+      values[i] = Pack::load(lanes);
+    }
+    for (size_t i = static_cast<size_t>(0); i < N; ++i) {
+      for (size_t k = static_cast<size_t>(0); k < i; ++k) {
+        values[i] -= Pack::load(lu + (i * N + k) * size + index) * values[k];
+      }
+    }
+    for (size_t i = N; i-- > static_cast<size_t>(0);) {
+      for (size_t k = i + static_cast<size_t>(1); k < N; ++k) {
+        values[i] -= Pack::load(lu + (i * N + k) * size + index) * values[k];
+      }
+      values[i] /= Pack::load(lu + (i * N + i) * size + index);
+    }
+    store_batch<Pack>(result, size, index, N, values);
+  });
+  return x;
+}
+} // namespace sabai
@@ -6,124 +6,594 @@
 #include "sabai/products.hpp"
 #include "sabai/static.hpp"
 #include "sabai/string_representation.hpp"
+#include "sabai/task_graph.hpp"
+#include "sabai/trsm.hpp"
 
 #include <iostream>
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 namespace sabai {
 template <typename T> void swap(T &a, T &b) {
-  T temp = a;
-  a = b;
-  b = temp;
+  T temp = std::move(a);
+  a = std::move(b);
+  b = std::move(temp);
 }
 
-template <typename T> struct DynamicCholeskyDecomposition {
-  DynamicMatrix<T> cholesky;
+// How the dynamic factorizations schedule their work. Blocked runs one block
+// step after another and splits each step across the thread pool. Tiled
+// cuts the matrix into square tiles and runs a TaskGraph of tile kernels, so
+// later steps start on tiles whose inputs are ready while the current step
+// is still finishing.
+enum class Execution { Blocked, Tiled };
 
-  DynamicCholeskyDecomposition(const DynamicMatrix<T> &A) : cholesky(triu(A)) {
-    const size_t N = A.length();
-    for (size_t i = static_cast<size_t>(0); i < N; ++i) {
-      for (size_t j = i + static_cast<size_t>(1); j < N; ++j) {
-        const T factor = cholesky(i, j) / cholesky(i, i);
-        for (size_t k = j; k < N; ++k) {
-          cholesky(j, k) -= cholesky(i, k) * factor;
+// Columns per panel of the blocked Cholesky factorization.
+template <typename T> struct CholeskyBlocking {
+  static constexpr size_t block = static_cast<size_t>(64);
+};
+
+// The unblocked factorization of a diagonal block: overwrites the upper
+// triangle of a with U such that A = U^T U.
+template <typename T>
+void cholesky_factor_unblocked(const DynamicArrayView<T, 2> &a) {
+  const size_t n = a.shape(0);
+  for (size_t i = static_cast<size_t>(0); i < n; ++i) {
+    for (size_t k = static_cast<size_t>(0); k < i; ++k) {
+      const T factor = a(k, i);
+      for (size_t j = i; j < n; ++j) {
+        a(i, j) -= factor * a(k, j);
+      }
+    }
+    const T diagonal = std::sqrt(a(i, i));
+    a(i, i) = diagonal;
+    for (size_t j = i + static_cast<size_t>(1); j < n; ++j) {
+      a(i, j) /= diagonal;
+    }
+  }
+}
+
+// Symmetric rank-k update of the upper triangle of columns [begin, end) of
+// c: c -= u^T u. Everything above the diagonal is computed by GEMMs, block
+// column by block column and then strip by strip within each diagonal tile,
+// so only the small triangles on the diagonal are updated element-wise.
+template <typename T>
+void syrk_upper(const DynamicArrayView<const T, 2> &u,
+                const DynamicArrayView<T, 2> &c, size_t begin, size_t end) {
+  constexpr size_t block = CholeskyBlocking<T>::block;
+  constexpr size_t strip = GemmBlocking<T>::NR;
+  const size_t k = u.shape(0);
+  for (size_t j = begin; j < end; j += block) {
+    const size_t jb = std::min(block, end - j);
+    if (j > static_cast<size_t>(0)) {
+      gemm<T>(static_cast<T>(-1), u.block(0, 0, k, j).transposed(),
+              u.block(0, j, k, jb), static_cast<T>(1), c.block(0, j, j, jb));
+    }
+    for (size_t s = j; s < j + jb; s += strip) {
+      const size_t sb = std::min(strip, j + jb - s);
+      if (s > j) {
+        gemm<T>(static_cast<T>(-1), u.block(0, j, k, s - j).transposed(),
+                u.block(0, s, k, sb), static_cast<T>(1),
+                c.block(j, s, s - j, sb));
+      }
+      for (size_t inner = static_cast<size_t>(0); inner < k; ++inner) {
+        const T *u_row = u.data() + inner * u.stride(0);
+        for (size_t row = s; row < s + sb; ++row) {
+          const T factor = u_row[row * u.stride(1)];
+          T *c_row = c.data() + row * c.stride(0);
+          for (size_t column = row; column < s + sb; ++column) {
+            c_row[column * c.stride(1)] -= factor * u_row[column * u.stride(1)];
+          }
         }
       }
-      const T sqrt_factor = sqrt(cholesky(i, i));
-      for (size_t r = i; r < N; ++r) {
-        cholesky(i, i) /= sqrt_factor;
+    }
+  }
+}
+
+// Overwrites the upper triangle of the symmetric positive definite a with
+// the upper triangular U such that A = U^T U, LAPACK style. The strict lower
+// triangle is neither read nor written. Each step factors a diagonal block,
+// solves the block row to its right against it, and applies a symmetric
+// update to the trailing matrix. The last two are split across the thread
+// pool, the update into column ranges of equal work.
+template <typename T>
+void cholesky_factor_inplace(const DynamicArrayView<T, 2> &a) {
+  constexpr size_t block = CholeskyBlocking<T>::block;
+  const size_t n = a.shape(0);
+  if (a.shape(1) != n) {
+    throw MismatchedLength(n, a.shape(1));
+  }
+  for (size_t k = static_cast<size_t>(0); k < n; k += block) {
+    const size_t kb = std::min(block, n - k);
+    const size_t end = k + kb;
+    const DynamicArrayView<T, 2> diagonal = a.block(k, k, kb, kb);
+    cholesky_factor_unblocked(diagonal);
+    if (end == n) {
+      break;
+    }
+    const size_t rest = n - end;
+    const DynamicArrayView<T, 2> panel = a.block(k, end, kb, rest);
+    const DynamicArrayView<T, 2> trailing = a.block(end, end, rest, rest);
+    const bool parallel =
+        rest * rest * kb >= GemmBlocking<T>::parallel_threshold;
+
+    // U12 = U11^-T A12
+    auto solve_columns = [&](size_t begin, size_t finish) {
+      trsm<T>(Triangle::Lower, false, diagonal.transposed(),
+              panel.block(0, begin, kb, finish - begin));
+    };
+    if (parallel) {
+      thread_pool().parallel_for(rest, GemmBlocking<T>::NR, solve_columns);
+    } else {
+      solve_columns(static_cast<size_t>(0), rest);
+    }
+
+    // A22 -= U12^T U12. Column j of the upper triangle costs about j, so
+    // chunk p of P covers columns rest * sqrt(p / P) to rest * sqrt((p+1)/P).
+    const size_t chunks = parallel ? thread_pool().size()
+                                   : static_cast<size_t>(1);
+    auto boundary = [&](size_t chunk) {
+      const double fraction =
+          std::sqrt(static_cast<double>(chunk) / static_cast<double>(chunks));
+      return std::min(round_up(static_cast<size_t>(fraction * rest),
+                               GemmBlocking<T>::NR),
+                      rest);
+    };
+    thread_pool().parallel_for(
+        chunks, static_cast<size_t>(1), [&](size_t first, size_t last) {
+          syrk_upper<T>(panel, trailing, boundary(first), boundary(last));
+        });
+  }
+}
+
+// The same factorization as cholesky_factor_inplace, as a graph of tile
+// tasks: POTRF on the diagonal tiles, TRSM on the tiles to their right and
+// SYRK or GEMM updates on the trailing tiles. Each task depends on the last
+// tasks that wrote the tiles it touches.
+template <typename T>
+void cholesky_factor_tiled(const DynamicArrayView<T, 2> &a,
+                           ThreadPool &pool = thread_pool()) {
+  using TaskId = TaskGraph::TaskId;
+  constexpr size_t block = CholeskyBlocking<T>::block;
+  const size_t n = a.shape(0);
+  if (a.shape(1) != n) {
+    throw MismatchedLength(n, a.shape(1));
+  }
+  const size_t tiles = (n + block - static_cast<size_t>(1)) / block;
+  auto tile = [&a, n, block](size_t i, size_t j) {
+    return a.block(i * block, j * block, std::min(block, n - i * block),
+                   std::min(block, n - j * block));
+  };
+  TaskGraph graph;
+  std::vector<TaskId> last(tiles * tiles, TaskGraph::none);
+  for (size_t k = static_cast<size_t>(0); k < tiles; ++k) {
+    const TaskId potrf = graph.add(
+        [tile, k] { cholesky_factor_unblocked(tile(k, k)); },
+        {last[k * tiles + k]});
+    last[k * tiles + k] = potrf;
+    for (size_t j = k + static_cast<size_t>(1); j < tiles; ++j) {
+      last[k * tiles + j] = graph.add(
+          [tile, k, j] {
+            trsm<T>(Triangle::Lower, false, tile(k, k).transposed(),
+                    tile(k, j));
+          },
+          {potrf, last[k * tiles + j]});
+    }
+    for (size_t i = k + static_cast<size_t>(1); i < tiles; ++i) {
+      for (size_t j = i; j < tiles; ++j) {
+        last[i * tiles + j] = graph.add(
+            [tile, k, i, j] {
+              if (i == j) {
+                const DynamicArrayView<T, 2> c = tile(i, i);
+                syrk_upper<T>(tile(k, i), c, static_cast<size_t>(0),
+                              c.shape(1));
+              } else {
+                gemm<T>(static_cast<T>(-1), tile(k, i).transposed(),
+                        tile(k, j), static_cast<T>(1), tile(i, j));
+              }
+            },
+            {last[k * tiles + i], last[k * tiles + j], last[i * tiles + j]});
+      }
+    }
+  }
+  graph.run(pool);
+}
+
+template <typename T>
+void cholesky_factor_inplace(const DynamicArrayView<T, 2> &a,
+                             Execution execution) {
+  if (execution == Execution::Tiled) {
+    cholesky_factor_tiled(a);
+  } else {
+    cholesky_factor_inplace(a);
+  }
+}
+
+// Checks a workspace passed to one of the factor methods against the size
+// its workspace query returned.
+template <typename T>
+void check_workspace(const DynamicArrayView<T, 1> &workspace, size_t size) {
+  if (workspace.length() < size) {
+    throw MismatchedLength(workspace.length(), size);
+  }
+}
+
+// The Dynamic decompositions can be constructed empty and then refactored
+// with factor(A, workspace), which reuses their storage whenever A has as
+// many elements as the last matrix factored. Together with a workspace of
+// at least workspace_size(m, n) elements, a steady-state refactorization
+// makes no heap allocations. To keep it that way it runs on the calling
+// thread, since handing work to the pool allocates.
+
+template <typename T> struct DynamicCholeskyDecomposition {
+  DynamicMatrix<T> cholesky;
+
+  DynamicCholeskyDecomposition() = default;
+
+  DynamicCholeskyDecomposition(const DynamicMatrix<T> &A,
+                               Execution execution = Execution::Blocked)
+      : cholesky(triu(A)) {
+    cholesky_factor_inplace(cholesky.view(), execution);
+  }
+
+  // The factorization works in place, so it needs no workspace.
+  static size_t workspace_size(size_t, size_t) {
+    return static_cast<size_t>(0);
+  }
+
+  void factor(const DynamicMatrix<T> &A,
+              const DynamicArrayView<T, 1> &workspace) {
+    const size_t n = A.length();
+    if (A.shape(1) != n) {
+      throw MismatchedLength(n, A.shape(1));
+    }
+    check_workspace(workspace, workspace_size(n, n));
+    cholesky.allocate(n, n);
+    for (size_t row = static_cast<size_t>(0); row < n; ++row) {
+      for (size_t column = static_cast<size_t>(0); column < n; ++column) {
+        cholesky(row, column) =
+            column < row ? static_cast<T>(0) : A(row, column);
       }
     }
+    const ThreadPool::SerialScope serial;
+    cholesky_factor_inplace(cholesky.view());
   }
 };
 
+// The upper triangular U with A = U^T U, computed a row at a time in place
+// so that no storage beyond the StaticArray member is used.
 template <typename T, size_t N> struct CholeskyDecomposition {
   StaticArray<T, N, N> cholesky;
 
   CholeskyDecomposition(const StaticArray<T, N, N> &A) : cholesky(triu(A)) {
     for (size_t i = static_cast<size_t>(0); i < N; ++i) {
-      for (size_t j = i + static_cast<size_t>(1); j < N; ++j) {
-        const T factor = cholesky(i, j) / cholesky(i, i);
-        for (size_t k = j; k < N; ++k) {
-          cholesky(j, k) -= cholesky(i, k) * factor;
+      for (size_t k = static_cast<size_t>(0); k < i; ++k) {
+        for (size_t j = i; j < N; ++j) {
+          cholesky(i, j) -= cholesky(k, i) * cholesky(k, j);
         }
       }
-      const T sqrt_factor = sqrt(cholesky(i, i));
-      for (size_t r = i; r < N; ++r) {
-        cholesky(i, i) /= sqrt_factor;
+      const T diagonal = std::sqrt(cholesky(i, i));
+      cholesky(i, i) = diagonal;
+      for (size_t j = i + static_cast<size_t>(1); j < N; ++j) {
+        cholesky(i, j) /= diagonal;
       }
     }
   }
 };
 
-template <typename T> struct DynamicLUDecomposition {
-  DynamicMatrix<T> L;
-  DynamicMatrix<T> U;
-  DynamicVector<size_t> P;
+// Columns per panel of the blocked LU factorization. Each panel is factored
+// unblocked, and the trailing matrix is then updated with a single GEMM.
+template <typename T> struct LUBlocking {
+  static constexpr size_t block = static_cast<size_t>(64);
+};
 
-  DynamicLUDecomposition(const DynamicMatrix<T> &A)
-      : U(A), L(Identity<T>(A.length())), P(ARange(A(0).length())) {
-    const size_t M = A.length();
-    const size_t N = A(0).length();
-    for (size_t k = static_cast<size_t>(0); k < N; ++k) {
-      // Select index i>=k that maximizes std::abs(U(i,k))
-      size_t i = k;
-      T max_value = std::abs(U(i, k));
-      for (size_t dummy_i = k; dummy_i < M; ++dummy_i) {
-        const T value = std::abs(U(dummy_i, k));
-        if (value > max_value) {
-          i = dummy_i;
-          max_value = value;
+template <typename T>
+void swap_rows(const DynamicArrayView<T, 2> &a, size_t first, size_t second) {
+  T *first_row = a.data() + first * a.stride(0);
+  T *second_row = a.data() + second * a.stride(0);
+  for (size_t column = static_cast<size_t>(0); column < a.shape(1);
+       ++column) {
+    swap(first_row[column * a.stride(1)], second_row[column * a.stride(1)]);
+  }
+}
+
+// Factors the panel a[k:m, k:k+kb] with partial pivoting, applying its row
+// swaps and eliminations to columns [k, columns) only. Records the swaps in
+// pivots(k) to pivots(k+kb-1), LAPACK style. The pivot search walks down a
+// column, so column-major storage keeps both it and the eliminations on
+// contiguous memory.
+template <typename T>
+void lu_factor_panel(const DynamicArrayView<T, 2> &a,
+                     const DynamicArrayView<size_t, 1> &pivots, size_t k,
+                     size_t kb, size_t columns) {
+  const size_t m = a.shape(0);
+  const DynamicArrayView<T, 2> panel = a.block(0, k, m, columns - k);
+  for (size_t j = k; j < k + kb; ++j) {
+    size_t pivot = j;
+    T max_value = std::abs(a(j, j));
+    for (size_t row = j + static_cast<size_t>(1); row < m; ++row) {
+      const T value = std::abs(a(row, j));
+      if (value > max_value) {
+        pivot = row;
+        max_value = value;
+      }
+    }
+    pivots(j) = pivot;
+    if (pivot != j) {
+      swap_rows(panel, j, pivot);
+    }
+    const T diagonal = a(j, j);
+    if (diagonal == static_cast<T>(0)) {
+      continue;
+    }
+    if (a.stride(0) != static_cast<size_t>(1)) {
+      for (size_t row = j + static_cast<size_t>(1); row < m; ++row) {
+        const T factor = (a(row, j) /= diagonal);
+        for (size_t column = j + static_cast<size_t>(1); column < columns;
+             ++column) {
+          a(row, column) -= factor * a(j, column);
         }
       }
-      for (size_t j = k; j < N; ++j) {
-        swap(U(k, j), U(i, j));
+      continue;
+    }
+    // Column-major: scale column j, then update the columns to its right
+    // one contiguous column at a time.
+    T *l = a.data() + j * a.stride(1);
+    for (size_t row = j + static_cast<size_t>(1); row < m; ++row) {
+      l[row] /= diagonal;
+    }
+    for (size_t column = j + static_cast<size_t>(1); column < columns;
+         ++column) {
+      T *target = a.data() + column * a.stride(1);
+      const T u = target[j];
+      for (size_t row = j + static_cast<size_t>(1); row < m; ++row) {
+        target[row] -= l[row] * u;
       }
-      for (size_t j = static_cast<size_t>(0); j < k; ++j) {
-        swap(L(k, j), L(i, j));
+    }
+  }
+}
+
+// Applies the row swaps of steps [k, k+kb) to the columns of a.
+template <typename Pivots, typename T>
+void apply_panel_pivots(const Pivots &pivots, size_t k, size_t kb,
+                        const DynamicArrayView<T, 2> &a) {
+  for (size_t j = k; j < k + kb; ++j) {
+    if (pivots(j) != j) {
+      swap_rows(a, j, pivots(j));
+    }
+  }
+}
+
+// Right-looking blocked LU with partial pivoting. Overwrites a with the unit
+// lower triangular factor below the diagonal and the upper triangular factor
+// on and above it. Row j was swapped with row pivots(j) at step j, LAPACK
+// style, so pivots has one entry per step.
+template <typename T>
+void lu_factor_blocked(const DynamicArrayView<T, 2> &a,
+                       const DynamicArrayView<size_t, 1> &pivots) {
+  const size_t m = a.shape(0);
+  const size_t n = a.shape(1);
+  const size_t steps = std::min(m, n);
+  if (pivots.length() != steps) {
+    throw MismatchedLength(pivots.length(), steps);
+  }
+  for (size_t k = static_cast<size_t>(0); k < steps;
+       k += LUBlocking<T>::block) {
+    const size_t kb = std::min(LUBlocking<T>::block, steps - k);
+    const size_t end = k + kb;
+    lu_factor_panel(a, pivots, k, kb, end);
+    if (k > static_cast<size_t>(0)) {
+      apply_panel_pivots(pivots, k, kb, a.block(0, 0, m, k));
+    }
+    if (end < n) {
+      apply_panel_pivots(pivots, k, kb, a.block(0, end, m, n - end));
+      // U12 = L11^-1 A12
+      trsm<T>(Triangle::Lower, true, a.block(k, k, kb, kb),
+              a.block(k, end, kb, n - end));
+      // A22 -= L21 U12
+      if (end < m) {
+        gemm<T>(static_cast<T>(-1), a.block(end, k, m - end, kb),
+                a.block(k, end, kb, n - end), static_cast<T>(1),
+                a.block(end, end, m - end, n - end));
       }
-      swap(P(k), P(i));
+    }
+  }
+}
 
-      for (size_t row = k + static_cast<size_t>(1); row < M; ++row) {
-        L(row, k) = U(row, k) / U(k, k);
-        for (size_t column = k; column < N; ++column) {
-          U(row, column) -= L(row, k) * U(k, column);
+// The same factorization as lu_factor_blocked, as a graph of tile tasks.
+// Step k factors the rows of tile column k from the diagonal down (GETRF),
+// then each tile column j to its right applies the step's row swaps and
+// solves its diagonal-row tile (TRSM) before the tiles below are updated
+// (GEMM). The swaps left of each panel are applied once the graph is done.
+template <typename T>
+void lu_factor_tiled(const DynamicArrayView<T, 2> &a,
+                     const DynamicArrayView<size_t, 1> &pivots,
+                     ThreadPool &pool = thread_pool()) {
+  using TaskId = TaskGraph::TaskId;
+  constexpr size_t block = LUBlocking<T>::block;
+  const size_t m = a.shape(0);
+  const size_t n = a.shape(1);
+  const size_t steps = std::min(m, n);
+  if (pivots.length() != steps) {
+    throw MismatchedLength(pivots.length(), steps);
+  }
+  const size_t row_tiles = (m + block - static_cast<size_t>(1)) / block;
+  const size_t column_tiles = (n + block - static_cast<size_t>(1)) / block;
+  const size_t step_tiles = (steps + block - static_cast<size_t>(1)) / block;
+  auto width = [n, block](size_t j) { return std::min(block, n - j * block); };
+  auto height = [m, block](size_t i) { return std::min(block, m - i * block); };
+  TaskGraph graph;
+  std::vector<TaskId> last(row_tiles * column_tiles, TaskGraph::none);
+  std::vector<TaskId> dependencies;
+  for (size_t k = static_cast<size_t>(0); k < step_tiles; ++k) {
+    const size_t k0 = k * block;
+    const size_t kb = std::min(block, steps - k0);
+    dependencies.clear();
+    for (size_t i = k; i < row_tiles; ++i) {
+      dependencies.push_back(last[i * column_tiles + k]);
+    }
+    // When m < n the last panel is narrower than its tile column, and
+    // lu_factor_panel also finishes the columns beyond it.
+    const TaskId getrf = graph.add(
+        [&a, &pivots, k0, kb, columns = k0 + width(k)] {
+          lu_factor_panel(a, pivots, k0, kb, columns);
+        },
+        dependencies);
+    for (size_t i = k; i < row_tiles; ++i) {
+      last[i * column_tiles + k] = getrf;
+    }
+    for (size_t j = k + static_cast<size_t>(1); j < column_tiles; ++j) {
+      dependencies.assign(1, getrf);
+      for (size_t i = k; i < row_tiles; ++i) {
+        dependencies.push_back(last[i * column_tiles + j]);
+      }
+      const TaskId trsm_task = graph.add(
+          [&a, &pivots, m, k0, kb, j0 = j * block, jb = width(j)] {
+            apply_panel_pivots(pivots, k0, kb, a.block(0, j0, m, jb));
+            trsm<T>(Triangle::Lower, true, a.block(k0, k0, kb, kb),
+                    a.block(k0, j0, kb, jb));
+          },
+          dependencies);
+      for (size_t i = k; i < row_tiles; ++i) {
+        last[i * column_tiles + j] = trsm_task;
+      }
+    }
+    for (size_t i = k + static_cast<size_t>(1); i < row_tiles; ++i) {
+      for (size_t j = k + static_cast<size_t>(1); j < column_tiles; ++j) {
+        last[i * column_tiles + j] = graph.add(
+            [&a, k0, kb, i0 = i * block, ib = height(i), j0 = j * block,
+             jb = width(j)] {
+              gemm<T>(static_cast<T>(-1), a.block(i0, k0, ib, kb),
+                      a.block(k0, j0, kb, jb), static_cast<T>(1),
+                      a.block(i0, j0, ib, jb));
+            },
+            {getrf, last[i * column_tiles + j]});
+      }
+    }
+  }
+  graph.run(pool);
+  for (size_t k0 = block; k0 < steps; k0 += block) {
+    apply_panel_pivots(pivots, k0, std::min(block, steps - k0),
+                       a.block(0, 0, m, k0));
+  }
+}
+
+template <typename T>
+void lu_factor_inplace(const DynamicArrayView<T, 2> &a,
+                       const DynamicArrayView<size_t, 1> &pivots,
+                       Execution execution = Execution::Blocked) {
+  if (execution == Execution::Tiled) {
+    lu_factor_tiled(a, pivots);
+  } else {
+    lu_factor_blocked(a, pivots);
+  }
+}
+
+// Applies the row swaps recorded by lu_factor_blocked to the elements of b,
+// in order.
+template <typename Pivots, typename Array>
+void apply_pivots(const Pivots &pivots, Array &&b) {
+  for (size_t j = static_cast<size_t>(0); j < pivots.length(); ++j) {
+    if (pivots(j) != j) {
+      swap(b(j), b(pivots(j)));
+    }
+  }
+}
+
+// L and U are kept as dense M x M and M x N matrices, like the members of
+// LUDecomposition. DynamicPackedLUDecomposition holds the same factors in
+// the storage of A alone.
+template <typename T> struct DynamicLUDecomposition {
+  DynamicMatrix<T> L;
+  DynamicMatrix<T> U;
+  // Row i of L * U is row P(i) of A.
+  DynamicVector<size_t> P;
+  // The row swaps that produce P, which let solve_inplace permute without
+  // extra storage.
+  DynamicVector<size_t> pivots;
+
+  DynamicLUDecomposition() = default;
+
+  DynamicLUDecomposition(const DynamicMatrix<T> &A,
+                         Execution execution = Execution::Blocked) {
+    compute(A, execution);
+  }
+
+  // L and U are factored in place, so no workspace is needed.
+  static size_t workspace_size(size_t, size_t) {
+    return static_cast<size_t>(0);
+  }
+
+  void factor(const DynamicMatrix<T> &A,
+              const DynamicArrayView<T, 1> &workspace) {
+    check_workspace(workspace, workspace_size(A.length(), A.shape(1)));
+    const ThreadPool::SerialScope serial;
+    compute(A, Execution::Blocked);
+  }
+
+private:
+  void compute(const DynamicMatrix<T> &A, Execution execution) {
+    const size_t M = A.length();
+    const size_t N = A.shape(1);
+    L.allocate(M, M);
+    U = A;
+    P.allocate(M);
+    for (size_t row = static_cast<size_t>(0); row < M; ++row) {
+      P(row) = row;
+    }
+    pivots.allocate(std::min(M, N));
+    lu_factor_inplace(U.view(), pivots.view(), execution);
+    apply_pivots(pivots, P);
+    for (size_t row = static_cast<size_t>(0); row < M; ++row) {
+      for (size_t column = static_cast<size_t>(0); column < M; ++column) {
+        if (column < row && column < N) {
+          L(row, column) = U(row, column);
+          U(row, column) = static_cast<T>(0);
+        } else {
+          L(row, column) = static_cast<T>(row == column ? 1 : 0);
         }
       }
     }
   }
 };
 
+// Gaussian elimination with partial pivoting on StaticArray members only,
+// so factoring and solving never touch the heap.
 template <typename T, size_t M, size_t N> struct LUDecomposition {
   StaticArray<T, M, M> L;
   StaticArray<T, M, N> U;
-  StaticVector<size_t, N> P;
+  StaticVector<size_t, M> P;
 
   LUDecomposition(const StaticArray<T, M, N> &A)
-      : U(A), L(Identity<T, M>()), P(ARange<N>()) {
-    for (size_t k = static_cast<size_t>(0); k < N; ++k) {
-      // Select index i>=k that maximizes std::abs(U(i,k))
-      size_t i = k;
-      T max_value = std::abs(U(i, k));
-      for (size_t dummy_i = k; dummy_i < M; ++dummy_i) {
-        const T value = std::abs(U(dummy_i, k));
+      : L(Identity<T, M>()), U(A), P(ARange<M>()) {
+    for (size_t k = static_cast<size_t>(0); k < std::min(M, N); ++k) {
+      size_t pivot = k;
+      T max_value = std::abs(U(k, k));
+      for (size_t row = k + static_cast<size_t>(1); row < M; ++row) {
+        const T value = std::abs(U(row, k));
         if (value > max_value) {
-          i = dummy_i;
+          pivot = row;
           max_value = value;
         }
       }
-      for (size_t j = k; j < N; ++j) {
-        swap(U(k, j), U(i, j));
+      if (pivot != k) {
+        for (size_t j = k; j < N; ++j) {
+          swap(U(k, j), U(pivot, j));
+        }
+        for (size_t j = static_cast<size_t>(0); j < k; ++j) {
+          swap(L(k, j), L(pivot, j));
+        }
+        swap(P(k), P(pivot));
       }
-      for (size_t j = static_cast<size_t>(0); j < k; ++j) {
-        swap(L(k, j), L(i, j));
+      if (U(k, k) == static_cast<T>(0)) {
+        continue;
       }
-      swap(P(k), P(i));
-
       for (size_t row = k + static_cast<size_t>(1); row < M; ++row) {
         L(row, k) = U(row, k) / U(k, k);
-        for (size_t column = k; column < N; ++column) {
+        U(row, k) = static_cast<T>(0);
+        for (size_t column = k + static_cast<size_t>(1); column < N;
+             ++column) {
           U(row, column) -= L(row, k) * U(k, column);
         }
       }
@@ -131,76 +601,284 @@ template <typename T, size_t M, size_t N> struct LUDecomposition {
   }
 };
 
-template <typename T, size_t M, size_t N> struct QRDecomposition {
-  StaticArray<T, M, N> R;
-  StaticArray<T, M, M> Q;
-
-  QRDecomposition(const StaticArray<T, M, N> &A) : R(A), Q(Identity<T, M>()) {
-    for (size_t k = static_cast<size_t>(0); k < N; ++k) {
-      DynamicVector<T> u(M - k);
-      for (size_t i = k; i < R.length(); ++i) {
-        u(i - k) = R(i, k);
-      }
-      const T norm_u = norm(u);
-      u(0) += norm_u * (u(0) < 0 ? static_cast<T>(-1) : static_cast<T>(1));
-      u /= norm(u);
+// Turns column of a, from row start down, into the Householder vector v of a
+// reflector H = I - tau v v^T that maps that part of the column onto a
+// multiple beta of e_1. beta overwrites the diagonal and v the elements below
+// it, with v(0) = 1 implied. Returns tau, which is zero when the column is
+// already reduced.
+template <typename T, typename Matrix>
+T householder_reflector(Matrix &&a, size_t start, size_t column) {
+  const T alpha = a(start, column);
+  T norm_below = static_cast<T>(0);
+  for (size_t row = start + static_cast<size_t>(1); row < a.length(); ++row) {
+    norm_below += a(row, column) * a(row, column);
+  }
+  if (norm_below == static_cast<T>(0)) {
+    return static_cast<T>(0);
+  }
+  const T norm = std::sqrt(alpha * alpha + norm_below);
+  const T beta = alpha < static_cast<T>(0) ? norm : -norm;
+  const T scale = static_cast<T>(1) / (alpha - beta);
+  for (size_t row = start + static_cast<size_t>(1); row < a.length(); ++row) {
+    a(row, column) *= scale;
+  }
+  a(start, column) = beta;
+  return (beta - alpha) / beta;
+}
+
+// Applies the reflector stored in column of factors by householder_reflector
+// to columns [first, end) of c from the left.
+template <typename T, typename Factors, typename Matrix>
+void apply_householder_reflector(const Factors &factors, size_t start,
+                                 size_t column, T tau, Matrix &&c,
+                                 size_t first, size_t end) {
+  if (tau == static_cast<T>(0)) {
+    return;
+  }
+  for (size_t target = first; target < end; ++target) {
+    T w = c(start, target);
+    for (size_t row = start + static_cast<size_t>(1); row < factors.length();
+         ++row) {
+      w += factors(row, column) * c(row, target);
+    }
+    w *= tau;
+    c(start, target) -= w;
+    for (size_t row = start + static_cast<size_t>(1); row < factors.length();
+         ++row) {
+      c(row, target) -= w * factors(row, column);
+    }
+  }
+}
 
-      DynamicMatrix<T> U = outer(u, u);
+// Reflectors per block of the QR factorization. A block is applied to the
+// rest of the matrix with two GEMMs.
+template <typename T> struct QRBlocking {
+  static constexpr size_t block = static_cast<size_t>(32);
+};
 
-      for (size_t i = k; i < M; ++i) {
-        for (size_t j = k; j < N; ++j) {
-          for (size_t s = static_cast<size_t>(0); s < U.length(); ++s) {
-            R(i, j) -= 2.0 * U(i - k, s) * R(s + k, j);
-          }
-        }
+// Forms the compact WY representation H_first ... H_(first + count - 1) =
+// I - V T V^T of a block of reflectors stored in a. v receives the unit lower
+// trapezoidal V, with a.length() - first rows, and t the upper triangular T.
+template <typename T>
+void householder_block(const DynamicArrayView<const T, 2> &a,
+                       const DynamicArrayView<const T, 1> &tau, size_t first,
+                       size_t count, const DynamicArrayView<T, 2> &v,
+                       const DynamicArrayView<T, 2> &t) {
+  const size_t rows = a.length() - first;
+  for (size_t row = static_cast<size_t>(0); row < rows; ++row) {
+    for (size_t column = static_cast<size_t>(0); column < count; ++column) {
+      v(row, column) = row > column    ? a(first + row, first + column)
+                       : row == column ? static_cast<T>(1)
+                                       : static_cast<T>(0);
+    }
+  }
+  // t(0:i, i) = -tau_i T(0:i, 0:i) V(:, 0:i)^T v_i
+  gemm<T>(static_cast<T>(1), v.transposed(), v, static_cast<T>(0), t);
+  for (size_t i = static_cast<size_t>(0); i < count; ++i) {
+    const T tau_i = tau(first + i);
+    for (size_t row = static_cast<size_t>(0); row < i; ++row) {
+      T value = static_cast<T>(0);
+      for (size_t inner = row; inner < i; ++inner) {
+        value += t(row, inner) * t(inner, i);
       }
+      t(row, i) = -tau_i * value;
+    }
+    t(i, i) = tau_i;
+    for (size_t row = i + static_cast<size_t>(1); row < count; ++row) {
+      t(row, i) = static_cast<T>(0);
+    }
+  }
+}
 
-      for (size_t i = k; i < M; ++i) {
-        for (size_t j = static_cast<size_t>(0); j < M; ++j) {
-          for (size_t s = static_cast<size_t>(0); s < U.length(); ++s) {
-            Q(i, j) -= 2.0 * U(i - k, s) * Q(s + k, j);
-          }
+// c = (I - V T V^T) c, or with T^T in place of T when transpose is set, using
+// w as a count x c.shape(1) workspace.
+template <typename T>
+void apply_householder_block(const DynamicArrayView<const T, 2> &v,
+                             const DynamicArrayView<const T, 2> &t,
+                             bool transpose,
+                             const DynamicArrayView<T, 2> &c,
+                             const DynamicArrayView<T, 2> &w) {
+  const size_t count = t.length();
+  gemm<T>(static_cast<T>(1), v.transposed(), c, static_cast<T>(0), w);
+  for (size_t column = static_cast<size_t>(0); column < c.shape(1);
+       ++column) {
+    if (transpose) {
+      for (size_t row = count; row-- > static_cast<size_t>(0);) {
+        T value = static_cast<T>(0);
+        for (size_t inner = static_cast<size_t>(0); inner <= row; ++inner) {
+          value += t(inner, row) * w(inner, column);
+        }
+        w(row, column) = value;
+      }
+    } else {
+      for (size_t row = static_cast<size_t>(0); row < count; ++row) {
+        T value = static_cast<T>(0);
+        for (size_t inner = row; inner < count; ++inner) {
+          value += t(row, inner) * w(inner, column);
         }
+        w(row, column) = value;
+      }
+    }
+  }
+  gemm<T>(static_cast<T>(-1), v, w, static_cast<T>(1), c);
+}
+
+// Elements of workspace qr_factor_blocked needs for an m x n matrix: the V,
+// T and W matrices of one block of reflectors.
+template <typename T> size_t qr_workspace_size(size_t m, size_t n) {
+  const size_t kb = std::min(QRBlocking<T>::block, std::min(m, n));
+  return kb * (m + kb + n);
+}
+
+// Householder QR. Overwrites a with R on and above the diagonal and the
+// Householder vectors below it, and tau with their scales. Each block of
+// reflectors is factored column by column and then applied to the trailing
+// columns in compact WY form, with V, T and W carved out of workspace.
+template <typename T>
+void qr_factor_blocked(const DynamicArrayView<T, 2> &a,
+                       const DynamicArrayView<T, 1> &tau,
+                       const DynamicArrayView<T, 1> &workspace) {
+  constexpr size_t block = QRBlocking<T>::block;
+  const size_t m = a.shape(0);
+  const size_t n = a.shape(1);
+  const size_t steps = std::min(m, n);
+  if (tau.length() != steps) {
+    throw MismatchedLength(tau.length(), steps);
+  }
+  check_workspace(workspace, qr_workspace_size<T>(m, n));
+  const size_t width = std::min(block, steps);
+  auto matrix = [&workspace](size_t offset, size_t rows, size_t columns) {
+    const size_t shape[2] = {rows, columns};
+    const size_t strides[2] = {columns, static_cast<size_t>(1)};
+    return DynamicArrayView<T, 2>(workspace.data() + offset, shape, strides);
+  };
+  const DynamicArrayView<T, 2> v = matrix(0, m, width);
+  const DynamicArrayView<T, 2> t = matrix(m * width, width, width);
+  const DynamicArrayView<T, 2> w = matrix((m + width) * width, width, n);
+  for (size_t k = static_cast<size_t>(0); k < steps; k += block) {
+    const size_t kb = std::min(block, steps - k);
+    const size_t end = k + kb;
+    for (size_t j = k; j < end; ++j) {
+      tau(j) = householder_reflector<T>(a, j, j);
+      apply_householder_reflector(a, j, j, tau(j), a,
+                                  j + static_cast<size_t>(1), end);
+    }
+    if (end < n) {
+      householder_block<T>(a, tau, k, kb, v.block(0, 0, m - k, kb),
+                           t.block(0, 0, kb, kb));
+      apply_householder_block<T>(v.block(0, 0, m - k, kb),
+                                 t.block(0, 0, kb, kb), true,
+                                 a.block(k, end, m - k, n - end),
+                                 w.block(0, 0, kb, n - end));
+    }
+  }
+}
+
+template <typename T>
+void qr_factor_blocked(const DynamicArrayView<T, 2> &a,
+                       const DynamicArrayView<T, 1> &tau) {
+  DynamicVector<T> workspace(qr_workspace_size<T>(a.shape(0), a.shape(1)));
+  qr_factor_blocked(a, tau, workspace.view());
+}
+
+template <typename T, size_t M, size_t N> struct QRDecomposition {
+  // R on and above the diagonal, and below it the Householder vectors.
+  StaticArray<T, M, N> factors;
+  StaticVector<T, std::min(M, N)> tau;
+
+  QRDecomposition(const StaticArray<T, M, N> &A) : factors(A) {
+    for (size_t k = static_cast<size_t>(0); k < std::min(M, N); ++k) {
+      tau(k) = householder_reflector<T>(factors, k, k);
+      apply_householder_reflector(factors, k, k, tau(k), factors,
+                                  k + static_cast<size_t>(1), N);
+    }
+  }
+
+  StaticArray<T, M, N> R() const {
+    StaticArray<T, M, N> r;
+    for (size_t row = static_cast<size_t>(0); row < M; ++row) {
+      for (size_t column = static_cast<size_t>(0); column < N; ++column) {
+        r(row, column) =
+            column < row ? static_cast<T>(0) : factors(row, column);
       }
     }
+    return r;
+  }
+
+  // The orthogonal factor, formed by applying the reflectors to the
+  // identity.
+  StaticArray<T, M, M> Q() const {
+    StaticArray<T, M, M> q = Identity<T, M>();
+    for (size_t k = std::min(M, N); k-- > static_cast<size_t>(0);) {
+      apply_householder_reflector(factors, k, k, tau(k), q, k, M);
+    }
+    return q;
   }
 };
 
 template <typename T> struct DynamicQRDecomposition {
-  DynamicMatrix<T> R;
-  DynamicMatrix<T> Q;
+  // R on and above the diagonal, and below it the Householder vectors.
+  DynamicMatrix<T> factors;
+  DynamicVector<T> tau;
+
+  DynamicQRDecomposition() = default;
 
   DynamicQRDecomposition(const DynamicMatrix<T> &A)
-      : R(A), Q(Identity<T>(A.length())) {
-    const size_t m = A.length();
-    const size_t n = A(0).length();
-    for (size_t k = static_cast<size_t>(0); k < n; ++k) {
-      DynamicVector<T> u(m - k);
-      for (size_t i = k; i < R.length(); ++i) {
-        u(i - k) = R(i, k);
-      }
-      const T norm_u = norm(u);
-      u(0) += norm_u * (u(0) < 0 ? static_cast<T>(-1) : static_cast<T>(1));
-      u /= norm(u);
+      : factors(A), tau(std::min(A.length(), A.shape(1))) {
+    qr_factor_blocked(factors.view(), tau.view());
+  }
 
-      DynamicMatrix<T> U = outer(u, u);
+  static size_t workspace_size(size_t m, size_t n) {
+    return qr_workspace_size<T>(m, n);
+  }
 
-      for (size_t i = k; i < m; ++i) {
-        for (size_t j = k; j < n; ++j) {
-          for (size_t s = static_cast<size_t>(0); s < U.length(); ++s) {
-            R(i, j) -= 2.0 * U(i - k, s) * R(s + k, j);
-          }
-        }
+  void factor(const DynamicMatrix<T> &A,
+              const DynamicArrayView<T, 1> &workspace) {
+    factors = A;
+    tau.allocate(std::min(A.length(), A.shape(1)));
+    const ThreadPool::SerialScope serial;
+    qr_factor_blocked(factors.view(), tau.view(), workspace);
+  }
+
+  DynamicMatrix<T> R() const {
+    const size_t m = factors.length();
+    const size_t n = factors.shape(1);
+    DynamicMatrix<T> r(m, n);
+    for (size_t row = static_cast<size_t>(0); row < m; ++row) {
+      for (size_t column = static_cast<size_t>(0); column < n; ++column) {
+        r(row, column) =
+            column < row ? static_cast<T>(0) : factors(row, column);
       }
+    }
+    return r;
+  }
 
-      for (size_t i = k; i < m; ++i) {
-        for (size_t j = 0; j < m; ++j) {
-          for (size_t s = 0; s < U.length(); ++s) {
-            Q(i, j) -= 2.0 * U(i - k, s) * Q(s + k, j);
-          }
-        }
+  // The m x m orthogonal factor, formed block by block from the reflectors.
+  DynamicMatrix<T> Q() const {
+    constexpr size_t block = QRBlocking<T>::block;
+    const size_t m = factors.length();
+    const size_t steps = tau.length();
+    DynamicMatrix<T> q = Identity<T>(m);
+    if (steps == static_cast<size_t>(0)) {
+      return q;
+    }
+    DynamicMatrix<T> v(m, std::min(block, steps));
+    DynamicMatrix<T> t(std::min(block, steps), std::min(block, steps));
+    DynamicMatrix<T> w(std::min(block, steps), m);
+    for (size_t k = (steps - static_cast<size_t>(1)) / block * block;;
+         k -= block) {
+      const size_t kb = std::min(block, steps - k);
+      householder_block<T>(factors.view(), tau.view(), k, kb,
+                           v.block(0, 0, m - k, kb), t.block(0, 0, kb, kb));
+      apply_householder_block<T>(v.block(0, 0, m - k, kb),
+                                 t.block(0, 0, kb, kb), false,
+                                 q.block(k, k, m - k, m - k),
+                                 w.block(0, 0, kb, m - k));
+      if (k == static_cast<size_t>(0)) {
+        break;
       }
     }
+    return q;
   }
 };
 
@@ -220,6 +898,12 @@ StaticVector<T, N> forward_substitution_solve(const StaticMatrix<T, N, N> &A,
 template <typename T>
 DynamicVector<T> forward_substitution_solve(const DynamicMatrix<T> &A,
                                             const DynamicVector<T> &b) {
+  if (A.length() != b.length()) {
+    throw MismatchedLength(A.length(), b.length());
+  }
+  if (A.shape(1) != b.length()) {
+    throw MismatchedLength(A.shape(1), b.length());
+  }
   DynamicVector<T> x(b);
   const size_t N = A.length();
   for (size_t index = 0; index < N; ++index) {
@@ -253,6 +937,12 @@ StaticVector<T, N> backward_substitution_solve(const StaticMatrix<T, N, N> &A,
 template <typename T>
 DynamicVector<T> backward_substitution_solve(const DynamicMatrix<T> &A,
                                              const DynamicVector<T> &b) {
+  if (A.length() != b.length()) {
+    throw MismatchedLength(A.length(), b.length());
+  }
+  if (A.shape(1) != b.length()) {
+    throw MismatchedLength(A.shape(1), b.length());
+  }
   DynamicVector<T> x(b);
   const size_t N = b.length();
   size_t index;
@@ -270,31 +960,122 @@ DynamicVector<T> backward_substitution_solve(const DynamicMatrix<T> &A,
   return x;
 }
 
+// The solve_inplace and solve_into overloads work entirely in the caller's
+// storage, so a factorization can be reused for any number of right-hand
+// sides without allocating.
+
+// Overwrites b with the solution of A x = b, solving U^T y = b and then
+// U x = y.
+template <typename T>
+void solve_inplace(const DynamicCholeskyDecomposition<T> &cholesky_decomp,
+                   DynamicVector<T> &b) {
+  const auto U = cholesky_decomp.cholesky.view();
+  const size_t n = U.length();
+  if (b.length() != n) {
+    throw MismatchedLength(n, b.length());
+  }
+  triangular_solve(Triangle::Lower, false, U.transposed(),
+                   as_column(b.view()), n, static_cast<size_t>(1));
+  triangular_solve(Triangle::Upper, false, U, as_column(b.view()), n,
+                   static_cast<size_t>(1));
+}
+
+// Writes the solution of A x = b into x, which must have the length of b.
+template <typename T>
+void solve_into(const DynamicCholeskyDecomposition<T> &cholesky_decomp,
+                const DynamicVector<T> &b, DynamicVector<T> &x) {
+  if (x.length() != b.length()) {
+    throw MismatchedLength(b.length(), x.length());
+  }
+  x = b;
+  solve_inplace(cholesky_decomp, x);
+}
+
 template <typename T>
 DynamicVector<T> solve(const DynamicCholeskyDecomposition<T> &cholesky_decomp,
                        const DynamicVector<T> &b) {
-  const DynamicVector<T> y =
-      forward_substitution_solve(cholesky_decomp.cholesky, b);
-  DynamicVector<T> x = backward_substitution_solve(cholesky_decomp.cholesky, y);
+  DynamicVector<T> x(b);
+  solve_inplace(cholesky_decomp, x);
   return x;
 }
 
+// Solves U^T y = b and then U x = y in place.
 template <typename T, size_t N>
 StaticVector<T, N> solve(const CholeskyDecomposition<T, N> &cholesky_decomp,
                          const StaticVector<T, N> &b) {
-  const StaticVector<T, N> y =
-      forward_substitution_solve(cholesky_decomp.cholesky, b);
-  StaticVector<T, N> x =
-      backward_substitution_solve(cholesky_decomp.cholesky, y);
+  const StaticArray<T, N, N> &U = cholesky_decomp.cholesky;
+  StaticVector<T, N> x(b);
+  for (size_t index = static_cast<size_t>(0); index < N; ++index) {
+    for (size_t row = static_cast<size_t>(0); row < index; ++row) {
+      x(index) -= U(row, index) * x(row);
+    }
+    x(index) /= U(index, index);
+  }
+  for (size_t index = N; index-- > static_cast<size_t>(0);) {
+    for (size_t column = index + static_cast<size_t>(1); column < N;
+         ++column) {
+      x(index) -= U(index, column) * x(column);
+    }
+    x(index) /= U(index, index);
+  }
   return x;
 }
 
+template <typename T>
+void lu_substitution_solve(const DynamicLUDecomposition<T> &lu_decomp,
+                           DynamicVector<T> &x) {
+  const size_t n = lu_decomp.L.length();
+  triangular_solve(Triangle::Lower, true, lu_decomp.L.view(),
+                   as_column(x.view()), n, static_cast<size_t>(1));
+  triangular_solve(Triangle::Upper, false, lu_decomp.U.view(),
+                   as_column(x.view()), n, static_cast<size_t>(1));
+}
+
+template <typename T>
+void check_lu_solve(const DynamicLUDecomposition<T> &lu_decomp,
+                    const DynamicVector<T> &b) {
+  const size_t n = lu_decomp.L.length();
+  if (lu_decomp.U.shape(1) != n) {
+    throw MismatchedLength(n, lu_decomp.U.shape(1));
+  }
+  if (b.length() != n) {
+    throw MismatchedLength(n, b.length());
+  }
+}
+
+// Overwrites b with the solution of A x = b. The row swaps are applied to b
+// one at a time, so no permuted copy is made.
+template <typename T>
+void solve_inplace(const DynamicLUDecomposition<T> &lu_decomp,
+                   DynamicVector<T> &b) {
+  check_lu_solve(lu_decomp, b);
+  apply_pivots(lu_decomp.pivots, b);
+  lu_substitution_solve(lu_decomp, b);
+}
+
+// Writes the solution of A x = b into x, which must have the length of b.
+template <typename T>
+void solve_into(const DynamicLUDecomposition<T> &lu_decomp,
+                const DynamicVector<T> &b, DynamicVector<T> &x) {
+  check_lu_solve(lu_decomp, b);
+  if (x.length() != b.length()) {
+    throw MismatchedLength(b.length(), x.length());
+  }
+  if (&x == &b) {
+    solve_inplace(lu_decomp, x);
+    return;
+  }
+  for (size_t index = static_cast<size_t>(0); index < b.length(); ++index) {
+    x(index) = b(lu_decomp.P(index));
+  }
+  lu_substitution_solve(lu_decomp, x);
+}
+
 template <typename T>
 DynamicVector<T> solve(const DynamicLUDecomposition<T> &lu_decomp,
                        const DynamicVector<T> &b) {
-  const DynamicVector<T> Pb = b(lu_decomp.P);
-  const DynamicVector<T> y = forward_substitution_solve(lu_decomp.L, Pb);
-  DynamicVector<T> x = backward_substitution_solve(lu_decomp.U, y);
+  DynamicVector<T> x(b.length());
+  solve_into(lu_decomp, b, x);
   return x;
 }
 
@@ -306,4 +1087,419 @@ StaticVector<T, N> solve(const LUDecomposition<T, M, N> &lu_decomp,
   StaticVector<T, N> x = backward_substitution_solve(lu_decomp.U, y);
   return x;
 }
+
+// Least-squares solution of A x = b for A with at least as many rows as
+// columns: applies Q^T to b and solves with the leading square of R.
+template <typename T, typename Factors, typename Vector, typename Tau>
+void qr_least_squares(const Factors &factors, const Tau &tau, Vector &y,
+                      size_t n) {
+  for (size_t k = static_cast<size_t>(0); k < tau.length(); ++k) {
+    if (tau(k) == static_cast<T>(0)) {
+      continue;
+    }
+    T w = y(k);
+    for (size_t row = k + static_cast<size_t>(1); row < y.length(); ++row) {
+      w += factors(row, k) * y(row);
+    }
+    w *= tau(k);
+    y(k) -= w;
+    for (size_t row = k + static_cast<size_t>(1); row < y.length(); ++row) {
+      y(row) -= w * factors(row, k);
+    }
+  }
+  for (size_t index = n; index-- > static_cast<size_t>(0);) {
+    for (size_t column = index + static_cast<size_t>(1); column < n;
+         ++column) {
+      y(index) -= factors(index, column) * y(column);
+    }
+    y(index) /= factors(index, index);
+  }
+}
+
+// Overwrites b, which has a row for each row of A, with Q^T b after solving
+// with R in place: the leading entries hold the least-squares solution and
+// the norm of the rest is the norm of its residual.
+template <typename T>
+void solve_inplace(const DynamicQRDecomposition<T> &qr_decomp,
+                   DynamicVector<T> &b) {
+  const size_t m = qr_decomp.factors.length();
+  const size_t n = qr_decomp.factors.shape(1);
+  if (b.length() != m) {
+    throw MismatchedLength(m, b.length());
+  }
+  if (m < n) {
+    throw MismatchedLength(m, n);
+  }
+  qr_least_squares<T>(qr_decomp.factors, qr_decomp.tau, b, n);
+}
+
+// Writes the least-squares solution of A x = b into x, which has a row for
+// each column of A. Q^T is applied to a copy of b in workspace, which needs
+// at least as many elements as b.
+template <typename T>
+void solve_into(const DynamicQRDecomposition<T> &qr_decomp,
+                const DynamicVector<T> &b, DynamicVector<T> &x,
+                const DynamicArrayView<T, 1> &workspace) {
+  const size_t m = qr_decomp.factors.length();
+  const size_t n = qr_decomp.factors.shape(1);
+  if (b.length() != m) {
+    throw MismatchedLength(m, b.length());
+  }
+  if (x.length() != n) {
+    throw MismatchedLength(n, x.length());
+  }
+  if (m < n) {
+    throw MismatchedLength(m, n);
+  }
+  check_workspace(workspace, m);
+  const size_t stride = static_cast<size_t>(1);
+  const DynamicArrayView<T, 1> y(workspace.data(), &m, &stride);
+  for (size_t index = static_cast<size_t>(0); index < m; ++index) {
+    y(index) = b(index);
+  }
+  qr_least_squares<T>(qr_decomp.factors, qr_decomp.tau, y, n);
+  for (size_t index = static_cast<size_t>(0); index < n; ++index) {
+    x(index) = y(index);
+  }
+}
+
+// As above, with a temporary workspace. For square A, Q^T is applied in x
+// itself, so nothing is allocated. Otherwise the temporary holds m elements
+// and allocates once m exceeds DynamicVector's small buffer; repeated tall
+// solves should pass their own workspace to the overload above.
+template <typename T>
+void solve_into(const DynamicQRDecomposition<T> &qr_decomp,
+                const DynamicVector<T> &b, DynamicVector<T> &x) {
+  const size_t m = qr_decomp.factors.length();
+  const size_t n = qr_decomp.factors.shape(1);
+  if (m == n && b.length() == m && x.length() == n) {
+    x = b;
+    solve_inplace(qr_decomp, x);
+    return;
+  }
+  DynamicVector<T> workspace(m);
+  solve_into(qr_decomp, b, x, workspace.view());
+}
+
+template <typename T>
+DynamicVector<T> solve(const DynamicQRDecomposition<T> &qr_decomp,
+                       const DynamicVector<T> &b) {
+  DynamicVector<T> x(qr_decomp.factors.shape(1));
+  solve_into(qr_decomp, b, x);
+  return x;
+}
+
+template <typename T, size_t M, size_t N>
+requires(M >= N) StaticVector<T, N> solve(
+    const QRDecomposition<T, M, N> &qr_decomp, const StaticVector<T, M> &b) {
+  StaticVector<T, M> y(b);
+  qr_least_squares<T>(qr_decomp.factors, qr_decomp.tau, y, N);
+  StaticVector<T, N> x;
+  for (size_t index = static_cast<size_t>(0); index < N; ++index) {
+    x(index) = y(index);
+  }
+  return x;
+}
+
+// Overloads for many right-hand sides, given as the columns of a matrix. The
+// factors are applied with a blocked triangular solve, so they are read once
+// per block of rows rather than once per right-hand side.
+
+template <typename T>
+DynamicMatrix<T> forward_substitution_solve(const DynamicMatrix<T> &A,
+                                            const DynamicMatrix<T> &B) {
+  DynamicMatrix<T> X(B);
+  trsm<T>(Triangle::Lower, false, A.view(), X.view());
+  return X;
+}
+
+template <typename T, size_t N, size_t K>
+StaticMatrix<T, N, K>
+forward_substitution_solve(const StaticMatrix<T, N, N> &A,
+                           const StaticMatrix<T, N, K> &B) {
+  StaticMatrix<T, N, K> X(B);
+  triangular_solve(Triangle::Lower, false, A, X, N, K);
+  return X;
+}
+
+template <typename T>
+DynamicMatrix<T> backward_substitution_solve(const DynamicMatrix<T> &A,
+                                             const DynamicMatrix<T> &B) {
+  DynamicMatrix<T> X(B);
+  trsm<T>(Triangle::Upper, false, A.view(), X.view());
+  return X;
+}
+
+template <typename T, size_t N, size_t K>
+StaticMatrix<T, N, K>
+backward_substitution_solve(const StaticMatrix<T, N, N> &A,
+                            const StaticMatrix<T, N, K> &B) {
+  StaticMatrix<T, N, K> X(B);
+  triangular_solve(Triangle::Upper, false, A, X, N, K);
+  return X;
+}
+
+template <typename T>
+DynamicMatrix<T> solve(const DynamicCholeskyDecomposition<T> &cholesky_decomp,
+                       const DynamicMatrix<T> &B) {
+  DynamicMatrix<T> X(B);
+  const auto U = cholesky_decomp.cholesky.view();
+  trsm<T>(Triangle::Lower, false, U.transposed(), X.view());
+  trsm<T>(Triangle::Upper, false, U, X.view());
+  return X;
+}
+
+template <typename T, size_t N, size_t K>
+StaticMatrix<T, N, K> solve(const CholeskyDecomposition<T, N> &cholesky_decomp,
+                            const StaticMatrix<T, N, K> &B) {
+  const StaticArray<T, N, N> &U = cholesky_decomp.cholesky;
+  StaticArray<T, N, N> Ut;
+  for (size_t row = static_cast<size_t>(0); row < N; ++row) {
+    for (size_t column = static_cast<size_t>(0); column < N; ++column) {
+      Ut(row, column) = U(column, row);
+    }
+  }
+  StaticMatrix<T, N, K> X(B);
+  triangular_solve(Triangle::Lower, false, Ut, X, N, K);
+  triangular_solve(Triangle::Upper, false, U, X, N, K);
+  return X;
+}
+
+template <typename T>
+DynamicMatrix<T> solve(const DynamicLUDecomposition<T> &lu_decomp,
+                       const DynamicMatrix<T> &B) {
+  if (B.length() != lu_decomp.P.length()) {
+    throw MismatchedLength(lu_decomp.P.length(), B.length());
+  }
+  DynamicMatrix<T> X = B(lu_decomp.P);
+  trsm<T>(Triangle::Lower, true, lu_decomp.L.view(), X.view());
+  trsm<T>(Triangle::Upper, false, lu_decomp.U.view(), X.view());
+  return X;
+}
+
+template <typename T, size_t N, size_t K>
+StaticMatrix<T, N, K> solve(const LUDecomposition<T, N, N> &lu_decomp,
+                            const StaticMatrix<T, N, K> &B) {
+  StaticMatrix<T, N, K> X = B(lu_decomp.P);
+  triangular_solve(Triangle::Lower, true, lu_decomp.L, X, N, K);
+  triangular_solve(Triangle::Upper, false, lu_decomp.U, X, N, K);
+  return X;
+}
+
+// Least-squares solutions for every column of B. Q^T is applied a block of
+// reflectors at a time in compact WY form.
+template <typename T>
+DynamicMatrix<T> solve(const DynamicQRDecomposition<T> &qr_decomp,
+                       const DynamicMatrix<T> &B) {
+  constexpr size_t block = QRBlocking<T>::block;
+  const size_t m = qr_decomp.factors.length();
+  const size_t n = qr_decomp.factors.shape(1);
+  const size_t columns = B.shape(1);
+  if (B.length() != m) {
+    throw MismatchedLength(m, B.length());
+  }
+  if (m < n) {
+    throw MismatchedLength(m, n);
+  }
+  DynamicMatrix<T> Y(B);
+  const size_t steps = qr_decomp.tau.length();
+  const size_t width = std::min(block, steps);
+  DynamicMatrix<T> v(m, width);
+  DynamicMatrix<T> t(width, width);
+  DynamicMatrix<T> w(width, columns);
+  for (size_t k = static_cast<size_t>(0); k < steps; k += block) {
+    const size_t kb = std::min(block, steps - k);
+    householder_block<T>(qr_decomp.factors.view(), qr_decomp.tau.view(), k,
+                         kb, v.block(0, 0, m - k, kb), t.block(0, 0, kb, kb));
+    apply_householder_block<T>(v.block(0, 0, m - k, kb),
+                               t.block(0, 0, kb, kb), true,
+                               Y.block(k, 0, m - k, columns),
+                               w.block(0, 0, kb, columns));
+  }
+  DynamicMatrix<T> X(Y.block(0, 0, n, columns));
+  trsm<T>(Triangle::Upper, false, qr_decomp.factors.block(0, 0, n, n),
+          X.view());
+  return X;
+}
+
+template <typename T, size_t M, size_t N, size_t K>
+requires(M >= N) StaticMatrix<T, N, K> solve(
+    const QRDecomposition<T, M, N> &qr_decomp, const StaticMatrix<T, M, K> &B) {
+  StaticMatrix<T, M, K> Y(B);
+  for (size_t k = static_cast<size_t>(0); k < std::min(M, N); ++k) {
+    apply_householder_reflector(qr_decomp.factors, k, k, qr_decomp.tau(k), Y,
+                                static_cast<size_t>(0), K);
+  }
+  triangular_solve(Triangle::Upper, false, qr_decomp.factors, Y, N, K);
+  StaticMatrix<T, N, K> X;
+  for (size_t row = static_cast<size_t>(0); row < N; ++row) {
+    for (size_t column = static_cast<size_t>(0); column < K; ++column) {
+      X(row, column) = Y(row, column);
+    }
+  }
+  return X;
+}
+
+// Factorizations that take over the storage of the matrix they factor and
+// overwrite it with the packed factors, so they need no memory beyond A and
+// the pivots. Pass the matrix with std::move to avoid copying it.
+
+// L below the diagonal, with its unit diagonal implied, and U on and above
+// it. Row j was swapped with row pivots(j) at step j.
+template <typename T> struct DynamicPackedLUDecomposition {
+  DynamicMatrix<T> factors;
+  DynamicVector<size_t> pivots;
+
+  explicit DynamicPackedLUDecomposition(
+      DynamicMatrix<T> A, Execution execution = Execution::Blocked)
+      : factors(std::move(A)),
+        pivots(std::min(factors.length(), factors.shape(1))) {
+    lu_factor_inplace(factors.view(), pivots.view(), execution);
+  }
+};
+
+// The upper triangle holds U with A = U^T U; the strict lower triangle keeps
+// the input.
+template <typename T> struct DynamicPackedCholeskyDecomposition {
+  DynamicMatrix<T> factors;
+
+  explicit DynamicPackedCholeskyDecomposition(
+      DynamicMatrix<T> A, Execution execution = Execution::Blocked)
+      : factors(std::move(A)) {
+    cholesky_factor_inplace(factors.view(), execution);
+  }
+};
+
+template <typename T>
+void solve_inplace(const DynamicPackedLUDecomposition<T> &lu_decomp,
+                   DynamicMatrix<T> &B) {
+  const auto factors = lu_decomp.factors.view();
+  if (factors.shape(1) != factors.length()) {
+    throw MismatchedLength(factors.length(), factors.shape(1));
+  }
+  if (B.length() != factors.length()) {
+    throw MismatchedLength(factors.length(), B.length());
+  }
+  apply_panel_pivots(lu_decomp.pivots, static_cast<size_t>(0),
+                     lu_decomp.pivots.length(), B.view());
+  trsm<T>(Triangle::Lower, true, factors, B.view());
+  trsm<T>(Triangle::Upper, false, factors, B.view());
+}
+
+template <typename T>
+void solve_inplace(const DynamicPackedLUDecomposition<T> &lu_decomp,
+                   DynamicVector<T> &b) {
+  const auto factors = lu_decomp.factors.view();
+  const size_t n = factors.length();
+  if (factors.shape(1) != n) {
+    throw MismatchedLength(n, factors.shape(1));
+  }
+  if (b.length() != n) {
+    throw MismatchedLength(n, b.length());
+  }
+  apply_pivots(lu_decomp.pivots, b);
+  triangular_solve(Triangle::Lower, true, factors, as_column(b.view()), n,
+                   static_cast<size_t>(1));
+  triangular_solve(Triangle::Upper, false, factors, as_column(b.view()), n,
+                   static_cast<size_t>(1));
+}
+
+template <typename T>
+void solve_inplace(const DynamicPackedCholeskyDecomposition<T> &cholesky_decomp,
+                   DynamicMatrix<T> &B) {
+  const auto U = cholesky_decomp.factors.view();
+  if (B.length() != U.length()) {
+    throw MismatchedLength(U.length(), B.length());
+  }
+  trsm<T>(Triangle::Lower, false, U.transposed(), B.view());
+  trsm<T>(Triangle::Upper, false, U, B.view());
+}
+
+template <typename T>
+void solve_inplace(const DynamicPackedCholeskyDecomposition<T> &cholesky_decomp,
+                   DynamicVector<T> &b) {
+  const auto U = cholesky_decomp.factors.view();
+  const size_t n = U.length();
+  if (b.length() != n) {
+    throw MismatchedLength(n, b.length());
+  }
+  triangular_solve(Triangle::Lower, false, U.transposed(),
+                   as_column(b.view()), n, static_cast<size_t>(1));
+  triangular_solve(Triangle::Upper, false, U, as_column(b.view()), n,
+                   static_cast<size_t>(1));
+}
+
+template <typename T>
+void solve_into(const DynamicPackedLUDecomposition<T> &lu_decomp,
+                const DynamicVector<T> &b, DynamicVector<T> &x) {
+  if (x.length() != b.length()) {
+    throw MismatchedLength(b.length(), x.length());
+  }
+  x = b;
+  solve_inplace(lu_decomp, x);
+}
+
+template <typename T>
+DynamicVector<T> solve(const DynamicPackedLUDecomposition<T> &lu_decomp,
+                       const DynamicVector<T> &b) {
+  DynamicVector<T> x(b);
+  solve_inplace(lu_decomp, x);
+  return x;
+}
+
+template <typename T>
+void solve_into(const DynamicPackedLUDecomposition<T> &lu_decomp,
+                const DynamicMatrix<T> &B, DynamicMatrix<T> &X) {
+  if (X.length() != B.length()) {
+    throw MismatchedLength(B.length(), X.length());
+  }
+  X = B;
+  solve_inplace(lu_decomp, X);
+}
+
+template <typename T>
+DynamicMatrix<T> solve(const DynamicPackedLUDecomposition<T> &lu_decomp,
+                       const DynamicMatrix<T> &B) {
+  DynamicMatrix<T> X(B);
+  solve_inplace(lu_decomp, X);
+  return X;
+}
+
+template <typename T>
+void solve_into(const DynamicPackedCholeskyDecomposition<T> &cholesky_decomp,
+                const DynamicVector<T> &b, DynamicVector<T> &x) {
+  if (x.length() != b.length()) {
+    throw MismatchedLength(b.length(), x.length());
+  }
+  x = b;
+  solve_inplace(cholesky_decomp, x);
+}
+
+template <typename T>
+DynamicVector<T>
+solve(const DynamicPackedCholeskyDecomposition<T> &cholesky_decomp,
+      const DynamicVector<T> &b) {
+  DynamicVector<T> x(b);
+  solve_inplace(cholesky_decomp, x);
+  return x;
+}
+
+template <typename T>
+void solve_into(const DynamicPackedCholeskyDecomposition<T> &cholesky_decomp,
+                const DynamicMatrix<T> &B, DynamicMatrix<T> &X) {
+  if (X.length() != B.length()) {
+    throw MismatchedLength(B.length(), X.length());
+  }
+  X = B;
+  solve_inplace(cholesky_decomp, X);
+}
+
+template <typename T>
+DynamicMatrix<T>
+solve(const DynamicPackedCholeskyDecomposition<T> &cholesky_decomp,
+      const DynamicMatrix<T> &B) {
+  DynamicMatrix<T> X(B);
+  solve_inplace(cholesky_decomp, X);
+  return X;
+}
 } // namespace sabai
\ No newline at end of file
@@ -1,58 +1,299 @@
 #pragma once
-#include "sabai/base.hpp"
+#include "sabai/expressions.hpp"
+#include "sabai/memory.hpp"
 
 #include <initializer_list>
+#include <type_traits>
+#include <utility>
 
 namespace sabai {
 
-class MismatchedLength : public std::exception {
-private:
-  size_t left_length_;
-  size_t right_length_;
+template <typename T, size_t... Shape> class DynamicArray;
+
+template <typename T, size_t NumDims> class DynamicArrayView {
+protected:
+  T *data_;
+  size_t shape_[NumDims];
+  size_t strides_[NumDims];
+
+  constexpr void check_bounds(size_t index) const {
+    if (index >= shape_[0]) {
+      throw OutOfRange(index, shape_[0]);
+    }
+  }
+
+  constexpr void check_input(size_t index) const {
+    if constexpr (bounds_checked) {
+      check_bounds(index);
+    }
+  }
 
 public:
-  MismatchedLength(size_t left_length, size_t right_length)
-      : left_length_(left_length), right_length_(right_length) {}
+  using ValueType = std::remove_const_t<T>;
+
+  constexpr DynamicArrayView(T *data, const size_t *shape,
+                             const size_t *strides)
+      : data_(data) {
+    for (size_t dim = static_cast<size_t>(0); dim < NumDims; ++dim) {
+      shape_[dim] = shape[dim];
+      strides_[dim] = strides[dim];
+    }
+  }
+
+  constexpr DynamicArrayView(const DynamicArrayView &view) = default;
+
+  // Read-only views of mutable data.
+  template <typename U>
+  requires(is_same<const U, T>::value) constexpr DynamicArrayView(
+      const DynamicArrayView<U, NumDims> &view)
+      : data_(view.data()) {
+    for (size_t dim = static_cast<size_t>(0); dim < NumDims; ++dim) {
+      shape_[dim] = view.shape(dim);
+      strides_[dim] = view.stride(dim);
+    }
+  }
+
+  constexpr T &operator()(size_t index) const
+      requires(NumDims == static_cast<size_t>(1)) {
+    check_input(index);
+    return data_[index * strides_[0]];
+  }
+
+  constexpr DynamicArrayView<T, NumDims - 1> operator()(size_t index) const
+      requires(NumDims > static_cast<size_t>(1)) {
+    check_input(index);
+    return DynamicArrayView<T, NumDims - 1>(data_ + index * strides_[0],
+                                            shape_ + 1, strides_ + 1);
+  }
+
+  template <typename... OtherIndices>
+  requires(sizeof...(OtherIndices) > 0 &&
+           sizeof...(OtherIndices) < NumDims) constexpr decltype(auto)
+  operator()(size_t index, OtherIndices... others) const {
+    return (*this)(index)(others...);
+  }
+
+  template <typename... OtherIndices>
+  requires(sizeof...(OtherIndices) < NumDims) constexpr decltype(auto)
+      at(size_t index, OtherIndices... others) const {
+    check_bounds(index);
+    if constexpr (sizeof...(OtherIndices) == static_cast<size_t>(0)) {
+      return (*this)(index);
+    } else {
+      return (*this)(index).at(others...);
+    }
+  }
+
+  constexpr DynamicArrayView<T, 1> column(size_t index) const
+      requires(NumDims == static_cast<size_t>(2)) {
+    if (index >= shape_[1]) {
+      throw OutOfRange(index, shape_[1]);
+    }
+    return DynamicArrayView<T, 1>(data_ + index * strides_[1], shape_,
+                                  strides_);
+  }
+
+  constexpr DynamicArrayView block(size_t row, size_t column, size_t rows,
+                                   size_t columns) const
+      requires(NumDims == static_cast<size_t>(2)) {
+    if (row + rows > shape_[0]) {
+      throw OutOfRange(row + rows - static_cast<size_t>(1), shape_[0]);
+    }
+    if (column + columns > shape_[1]) {
+      throw OutOfRange(column + columns - static_cast<size_t>(1), shape_[1]);
+    }
+    const size_t shape[2] = {rows, columns};
+    return DynamicArrayView(data_ + row * strides_[0] + column * strides_[1],
+                            shape, strides_);
+  }
 
-  ~MismatchedLength() override{};
+  // The transpose, viewed in place by swapping the strides.
+  constexpr DynamicArrayView transposed() const
+      requires(NumDims == static_cast<size_t>(2)) {
+    const size_t shape[2] = {shape_[1], shape_[0]};
+    const size_t strides[2] = {strides_[1], strides_[0]};
+    return DynamicArrayView(data_, shape, strides);
+  }
+
+  constexpr size_t length() const { return shape_[0]; }
+
+  constexpr size_t shape(size_t dim) const { return shape_[dim]; }
+
+  constexpr size_t stride(size_t dim) const { return strides_[dim]; }
+
+  constexpr T *data() const { return data_; }
+
+  constexpr void fill(ValueType value) const {
+    for (size_t index = static_cast<size_t>(0); index < shape_[0]; ++index) {
+      if constexpr (NumDims == static_cast<size_t>(1)) {
+        (*this)(index) = value;
+      } else {
+        (*this)(index).fill(value);
+      }
+    }
+  }
+
+  constexpr void operator=(const DynamicArrayView &array) const {
+    sabai::assign(*this, array);
+  }
 
-  const char *what() const noexcept override { return "mismatched lengths"; }
+  template <ArrayLike Array>
+  requires(array_traits<Array>::NumDims == NumDims) constexpr void
+  operator=(const Array &array) const {
+    sabai::assign(*this, array);
+  }
 };
 
-template <typename T, size_t... Shape> class DynamicArray;
+// Elements a DynamicVector of T keeps inside the object instead of on the
+// heap, so that short vectors such as cross products and 3- to 16-element
+// temporaries cost no allocation. Specialize to tune it; zero turns the
+// small buffer off.
+template <typename T> struct SmallBufferCapacity {
+  static constexpr size_t capacity =
+      std::is_trivial_v<T> ? static_cast<size_t>(128) / sizeof(T)
+                           : static_cast<size_t>(0);
+};
+
+// Uninitialized storage for Capacity elements, aligned like a heap buffer.
+template <typename T, size_t Capacity> struct InlineBuffer {
+  alignas(element_alignment<T>) T elements[Capacity];
+
+  constexpr T *data() { return elements; }
+};
+
+template <typename T> struct InlineBuffer<T, 0> {
+  constexpr T *data() { return nullptr; }
+};
 
 template <typename T> class DynamicArray<T, 1> {
+  template <typename U, size_t... OtherShape> friend class DynamicArray;
+
+public:
+  using View = DynamicArrayView<T, 1>;
+  using ConstView = DynamicArrayView<const T, 1>;
+
+  static constexpr size_t inline_capacity = SmallBufferCapacity<T>::capacity;
+
 protected:
   size_t length_;
+  std::pmr::memory_resource *resource_;
   T *data_;
+  [[no_unique_address]] InlineBuffer<T, inline_capacity> buffer_;
+
+  constexpr bool is_inline() const {
+    return inline_capacity > static_cast<size_t>(0) &&
+           data_ == const_cast<DynamicArray *>(this)->buffer_.data();
+  }
 
-  void check_input(size_t index) const {
-    if (index >= length_ || index < 0) {
+  // Storage for length elements: the small buffer when they fit in it, and
+  // otherwise a new buffer from resource_.
+  constexpr T *acquire(size_t length) {
+    if (length == static_cast<size_t>(0)) {
+      return nullptr;
+    }
+    if (length <= inline_capacity) {
+      return buffer_.data();
+    }
+    return allocate_elements<T>(resource_, length);
+  }
+
+  constexpr void release() {
+    if (!is_inline()) {
+      deallocate_elements(resource_, data_, length_);
+    }
+  }
+
+  // Takes over the elements of array, which is left empty, along with the
+  // resource it allocates from. Elements in its small buffer are copied;
+  // a heap buffer changes hands. Only called on an empty array.
+  constexpr void take(DynamicArray &array) noexcept {
+    length_ = array.length_;
+    resource_ = array.resource_;
+    if (array.is_inline()) {
+      data_ = buffer_.data();
+      for (size_t index = static_cast<size_t>(0); index < length_; ++index) {
+        data_[index] = array.data_[index];
+      }
+    } else {
+      data_ = array.data_;
+    }
+    array.length_ = static_cast<size_t>(0);
+    array.data_ = nullptr;
+  }
+
+  constexpr void check_bounds(size_t index) const {
+    if (index >= length_) {
       throw OutOfRange(index, length_);
     }
   }
 
+  constexpr void check_input(size_t index) const {
+    if constexpr (bounds_checked) {
+      check_bounds(index);
+    }
+  }
+
   void check_length_matches(const DynamicArray &array) const {
     if (length_ != array.length()) {
       throw MismatchedLength(length_, array.length());
     }
   }
 
+  static constexpr void read_shape(const std::initializer_list<T> &values,
+                                   size_t *shape) {
+    shape[0] = values.size();
+  }
+
+  static constexpr void copy_values(const std::initializer_list<T> &values,
+                                    T *data, const size_t *shape,
+                                    const size_t *strides) {
+    if (values.size() != shape[0]) {
+      throw MismatchedLength(shape[0], values.size());
+    }
+    size_t index = static_cast<size_t>(0);
+    for (const T &value : values) {
+      data[index * strides[0]] = value;
+      ++index;
+    }
+  }
+
 public:
   using InitializerList = std::initializer_list<T>;
 
-  constexpr DynamicArray() : length_(static_cast<size_t>(0)) {}
+  constexpr DynamicArray()
+      : length_(static_cast<size_t>(0)), resource_(current_memory_resource()),
+        data_(nullptr) {}
 
   constexpr DynamicArray(size_t _length)
-      : length_(_length), data_(new T[length_]) {}
+      : length_(_length), resource_(current_memory_resource()),
+        data_(acquire(length_)) {}
 
   constexpr DynamicArray(const DynamicArray &array)
-      : length_(array.length()), data_(new T[length_]) {
+      : length_(array.length()), resource_(current_memory_resource()),
+        data_(acquire(length_)) {
     fill(array);
   }
 
+  constexpr DynamicArray(DynamicArray &&array) noexcept
+      : length_(static_cast<size_t>(0)), resource_(array.resource_),
+        data_(nullptr) {
+    take(array);
+  }
+
+  // Evaluates views and elementwise expressions into a new array.
+  template <ArrayLike Array>
+  requires(!is_same<Array, DynamicArray>::value &&
+           is_same<typename array_traits<Array>::ArrayType,
+                   DynamicArray>::value) constexpr DynamicArray(const Array
+                                                                    &array)
+      : length_(array.length()), resource_(current_memory_resource()),
+        data_(acquire(length_)) {
+    sabai::assign(*this, array);
+  }
+
   constexpr DynamicArray(const InitializerList &values)
-      : length_(values.size()), data_(new T[length_]) {
+      : length_(values.size()), resource_(current_memory_resource()),
+        data_(acquire(length_)) {
     size_t index = 0;
     for (const T &value : values) {
       data_[index] = value;
@@ -60,11 +301,15 @@ public:
     }
   }
 
+  // Keeps the existing buffer when it already has the requested length.
   constexpr void allocate(size_t _length) {
-    if (length_ > static_cast<size_t>(0)) {
-      delete[] data_;
+    if (_length == length_) {
+      return;
     }
-    data_ = new T[_length];
+    release();
+    data_ = nullptr;
+    length_ = static_cast<size_t>(0);
+    data_ = acquire(_length);
     length_ = _length;
   }
 
@@ -72,12 +317,14 @@ public:
     allocate(array.length());
   }
 
-  constexpr ~DynamicArray() {
-    if (length_ > static_cast<size_t>(0)) {
-      delete[] data_;
-    }
+  template <ArrayLike Array> constexpr void allocate_like(const Array &array) {
+    allocate(array.length());
   }
 
+  constexpr ~DynamicArray() { release(); }
+
+  constexpr std::pmr::memory_resource *resource() const { return resource_; }
+
   constexpr T operator()(size_t index) const {
     check_input(index);
     return data_[index];
@@ -88,8 +335,36 @@ public:
     return data_[index];
   }
 
+  constexpr T at(size_t index) const {
+    check_bounds(index);
+    return data_[index];
+  }
+
+  constexpr T &at(size_t index) {
+    check_bounds(index);
+    return data_[index];
+  }
+
+  constexpr View view() {
+    const size_t stride = static_cast<size_t>(1);
+    return View(data_, &length_, &stride);
+  }
+
+  constexpr ConstView view() const {
+    const size_t stride = static_cast<size_t>(1);
+    return ConstView(data_, &length_, &stride);
+  }
+
   constexpr size_t length() const { return length_; }
 
+  constexpr size_t shape(size_t dim) const { return length_; }
+
+  constexpr size_t size() const { return length_; }
+
+  constexpr T *data() { return data_; }
+
+  constexpr const T *data() const { return data_; }
+
   constexpr void fill(const InitializerList &values) {
     if (length_ == static_cast<size_t>(0)) {
       allocate(values.size());
@@ -120,14 +395,52 @@ public:
     }
   }
 
-  constexpr void operator=(const DynamicArray &vector) {
-    if (length_ == static_cast<size_t>(0)) {
-      allocate(vector.length());
+  // Reuses the existing buffer when the lengths already match.
+  constexpr DynamicArray &operator=(const DynamicArray &vector) {
+    if (this != &vector) {
+      if (length_ != vector.length()) {
+        allocate(vector.length());
+      }
+      for (size_t index = static_cast<size_t>(0); index < length_; ++index) {
+        data_[index] = vector.data_[index];
+      }
     }
-    check_length_matches(vector);
-    for (size_t index = static_cast<size_t>(0); index < length_; ++index) {
-      data_[index] = vector(index);
+    return *this;
+  }
+
+  constexpr DynamicArray &operator=(DynamicArray &&vector) noexcept {
+    swap(vector);
+    return *this;
+  }
+
+  // Elementwise expressions are evaluated straight into the existing buffer
+  // when the lengths match.
+  template <ArrayLike Array>
+  requires(!is_same<Array, DynamicArray>::value &&
+           is_same<typename array_traits<Array>::ArrayType,
+                   DynamicArray>::value) constexpr DynamicArray &
+  operator=(const Array &array) {
+    if (length_ == array.length()) {
+      sabai::assign(*this, array);
+    } else {
+      *this = DynamicArray(array);
+    }
+    return *this;
+  }
+
+  // Exchanges heap buffers without copying; elements in a small buffer are
+  // copied across.
+  constexpr void swap(DynamicArray &vector) noexcept {
+    if (!is_inline() && !vector.is_inline()) {
+      std::swap(length_, vector.length_);
+      std::swap(resource_, vector.resource_);
+      std::swap(data_, vector.data_);
+      return;
     }
+    DynamicArray temporary;
+    temporary.take(vector);
+    vector.take(*this);
+    take(temporary);
   }
 
   constexpr DynamicArray
@@ -142,161 +455,492 @@ public:
   }
 };
 
+// The order in which an array of two or more dimensions stores its
+// elements. Row-major arrays keep each row contiguous, with the last index
+// varying fastest; column-major arrays keep each column contiguous, with the
+// first index varying fastest, as BLAS, LAPACK and Fortran expect.
+enum class Layout { RowMajor, ColumnMajor };
+
+// How the contiguous rows, or columns of a column-major array, are laid
+// out. Aligned pads each one to a whole number of array_alignment units, so
+// each starts as aligned as the buffer, and by one unit more when they
+// would otherwise be a multiple of 512 bytes apart. Such strides map a
+// sweep across them onto a handful of cache sets, and multiples of 4096
+// bytes alias in the store buffer as well.
+enum class RowPadding { None, Aligned };
+
+template <typename T>
+constexpr size_t padded_row_length(RowPadding padding, size_t columns) {
+  constexpr size_t unit = array_alignment / sizeof(T);
+  if (padding == RowPadding::None || array_alignment % sizeof(T) != 0 ||
+      columns == static_cast<size_t>(0)) {
+    return columns;
+  }
+  size_t length = (columns + unit - static_cast<size_t>(1)) / unit * unit;
+  if (length * sizeof(T) % static_cast<size_t>(512) == 0) {
+    length += unit;
+  }
+  return length;
+}
+
 template <typename T, size_t NumDims>
 requires(NumDims > static_cast<size_t>(1)) class DynamicArray<T, NumDims> {
+  template <typename U, size_t... OtherShape> friend class DynamicArray;
+
 public:
   using SubArray = DynamicArray<T, NumDims - 1>;
+  using View = DynamicArrayView<T, NumDims>;
+  using ConstView = DynamicArrayView<const T, NumDims>;
+  using InitializerList =
+      std::initializer_list<typename SubArray::InitializerList>;
 
 protected:
-  size_t length_;
-  SubArray *data_;
+  size_t shape_[NumDims];
+  size_t strides_[NumDims];
+  size_t size_;
+  Layout layout_;
+  RowPadding padding_;
+  std::pmr::memory_resource *resource_;
+  T *data_;
+
+  constexpr void check_bounds(size_t index) const {
+    if (index >= shape_[0]) {
+      throw OutOfRange(index, shape_[0]);
+    }
+  }
 
   constexpr void check_input(size_t index) const {
-    if (index >= length_) {
-      throw OutOfRange(index, length_);
+    if constexpr (bounds_checked) {
+      check_bounds(index);
     }
   }
 
-public:
-  using InitializerList =
-      std::initializer_list<typename SubArray::InitializerList>;
+  constexpr void check_shape_matches(const size_t *shape) const {
+    for (size_t dim = static_cast<size_t>(0); dim < NumDims; ++dim) {
+      if (shape_[dim] != shape[dim]) {
+        throw MismatchedLength(shape_[dim], shape[dim]);
+      }
+    }
+  }
 
-  constexpr DynamicArray() : length_(static_cast<size_t>(0)) {}
+  // The dimension whose elements are adjacent in memory, and the next one.
+  constexpr size_t contiguous_dim() const {
+    return layout_ == Layout::RowMajor ? NumDims - static_cast<size_t>(1)
+                                       : static_cast<size_t>(0);
+  }
 
-  template <typename... OtherDims>
-  requires(sizeof...(OtherDims) ==
-           (NumDims - 1)) constexpr DynamicArray(size_t _length,
-                                                 OtherDims... others)
-      : length_(_length), data_(new SubArray[length_]) {
-    for (size_t index = static_cast<size_t>(0); index < length_; ++index) {
-      data_[index].allocate(others...);
+  constexpr size_t leading_dim() const {
+    return layout_ == Layout::RowMajor ? NumDims - static_cast<size_t>(2)
+                                       : static_cast<size_t>(1);
+  }
+
+  // Every element lives in the single buffer data_, so element (i, j, ...)
+  // sits at i * strides_[0] + j * strides_[1] + ... The strides grow from
+  // the last dimension for row-major arrays and from the first for
+  // column-major ones. Padding makes size_ larger than the number of
+  // elements; it starts out zero, so passes over the whole buffer read
+  // defined values.
+  constexpr void allocate_shape(const size_t *shape) {
+    size_t size = static_cast<size_t>(1);
+    for (size_t step = static_cast<size_t>(0); step < NumDims; ++step) {
+      const size_t dim = layout_ == Layout::RowMajor
+                             ? NumDims - static_cast<size_t>(1) - step
+                             : step;
+      shape_[dim] = shape[dim];
+      strides_[dim] = size;
+      size = step == static_cast<size_t>(0)
+                 ? padded_row_length<T>(padding_, shape[dim])
+                 : size * shape[dim];
+    }
+    if (size != size_) {
+      deallocate_elements(resource_, data_, size_);
+      data_ = nullptr;
+      size_ = static_cast<size_t>(0);
+      data_ = allocate_elements<T>(resource_, size);
+      size_ = size;
+    }
+    if (strides_[leading_dim()] != shape_[contiguous_dim()]) {
+      fill(T());
     }
   }
 
-  constexpr DynamicArray(const DynamicArray &array)
-      : length_(array.length()), data_(new SubArray[length_]) {
-    for (size_t index = static_cast<size_t>(0); index < length_; ++index) {
-      data_[index].fill(array(index));
+  // Copies the elements of an array of the same shape, in a single pass
+  // when the two share a layout.
+  constexpr void copy_elements(const DynamicArray &array) {
+    bool same_layout = true;
+    for (size_t dim = static_cast<size_t>(0); dim < NumDims; ++dim) {
+      same_layout = same_layout && strides_[dim] == array.strides_[dim];
+    }
+    if (!same_layout) {
+      sabai::assign(*this, array);
+      return;
+    }
+    for (size_t index = static_cast<size_t>(0); index < size_; ++index) {
+      data_[index] = array.data_[index];
     }
   }
 
-  constexpr DynamicArray(const InitializerList &values)
-      : length_(values.size()), data_(new SubArray[length_]) {
+  template <bool Checked, typename... OtherIndices>
+  constexpr size_t offset(size_t index, OtherIndices... others) const {
+    const size_t indices[NumDims] = {index, static_cast<size_t>(others)...};
+    size_t element = static_cast<size_t>(0);
+    for (size_t dim = static_cast<size_t>(0); dim < NumDims; ++dim) {
+      if (Checked && indices[dim] >= shape_[dim]) {
+        throw OutOfRange(indices[dim], shape_[dim]);
+      }
+      element += indices[dim] * strides_[dim];
+    }
+    return element;
+  }
+
+  static constexpr void read_shape(const InitializerList &values,
+                                   size_t *shape) {
+    shape[0] = values.size();
+    if (values.size() > static_cast<size_t>(0)) {
+      SubArray::read_shape(*values.begin(), shape + 1);
+    }
+  }
+
+  static constexpr void copy_values(const InitializerList &values, T *data,
+                                    const size_t *shape,
+                                    const size_t *strides) {
+    if (values.size() != shape[0]) {
+      throw MismatchedLength(shape[0], values.size());
+    }
     size_t index = static_cast<size_t>(0);
-    for (typename SubArray::InitializerList value : values) {
-      data_[index].fill(value);
+    for (const typename SubArray::InitializerList &value : values) {
+      SubArray::copy_values(value, data + index * strides[0], shape + 1,
+                            strides + 1);
       ++index;
     }
   }
 
-  constexpr ~DynamicArray() {
-    if (length_ > static_cast<size_t>(0)) {
-      delete[] data_;
-    }
+public:
+  constexpr DynamicArray()
+      : shape_{}, strides_{}, size_(static_cast<size_t>(0)),
+        layout_(Layout::RowMajor), padding_(RowPadding::None),
+        resource_(current_memory_resource()), data_(nullptr) {}
+
+  template <typename... OtherDims>
+  requires(sizeof...(OtherDims) ==
+           (NumDims - 1)) constexpr DynamicArray(size_t _length,
+                                                 OtherDims... others)
+      : DynamicArray() {
+    allocate(_length, others...);
   }
 
+  // An array stored in the given layout, with its contiguous rows or
+  // columns padded as padding says. Both stay with the array when it is
+  // reallocated, and copies take them along.
+  template <typename... OtherDims>
+  requires(sizeof...(OtherDims) == (NumDims - 1)) constexpr DynamicArray(
+      Layout layout, RowPadding padding, size_t _length, OtherDims... others)
+      : DynamicArray() {
+    layout_ = layout;
+    padding_ = padding;
+    allocate(_length, others...);
+  }
+
+  template <typename... OtherDims>
+  requires(sizeof...(OtherDims) == (NumDims - 1)) constexpr DynamicArray(
+      RowPadding padding, size_t _length, OtherDims... others)
+      : DynamicArray(Layout::RowMajor, padding, _length, others...) {}
+
+  template <typename... OtherDims>
+  requires(sizeof...(OtherDims) == (NumDims - 1)) constexpr DynamicArray(
+      Layout layout, size_t _length, OtherDims... others)
+      : DynamicArray(layout, RowPadding::None, _length, others...) {}
+
+  constexpr DynamicArray(const DynamicArray &array) : DynamicArray() {
+    fill(array);
+  }
+
+  constexpr DynamicArray(DynamicArray &&array) noexcept : DynamicArray() {
+    swap(array);
+  }
+
+  // Evaluates views and elementwise expressions into a new array.
+  template <ArrayLike Array>
+  requires(!is_same<Array, DynamicArray>::value &&
+           is_same<typename array_traits<Array>::ArrayType,
+                   DynamicArray>::value) constexpr DynamicArray(const Array
+                                                                    &array)
+      : DynamicArray() {
+    allocate_like(array);
+    sabai::assign(*this, array);
+  }
+
+  constexpr DynamicArray(const InitializerList &values) : DynamicArray() {
+    fill(values);
+  }
+
+  constexpr ~DynamicArray() { deallocate_elements(resource_, data_, size_); }
+
+  constexpr std::pmr::memory_resource *resource() const { return resource_; }
+
   constexpr void fill(const DynamicArray &array) {
-    if (length_ == static_cast<size_t>(0)) {
-      allocate(array.length());
-    } else if (length_ != array.length()) {
-      throw MismatchedLength(length_, array.length());
-    }
-    for (size_t index = static_cast<size_t>(0); index < length_; ++index) {
-      data_[index].fill(array(index));
+    if (shape_[0] == static_cast<size_t>(0)) {
+      allocate_like(array);
+    } else {
+      check_shape_matches(array.shape_);
     }
+    copy_elements(array);
   }
 
-  constexpr SubArray operator()(size_t index) const {
+  constexpr typename SubArray::ConstView operator()(size_t index) const {
     check_input(index);
-    return data_[index];
+    return view()(index);
   }
 
-  constexpr SubArray &operator()(size_t index) {
+  constexpr typename SubArray::View operator()(size_t index) {
     check_input(index);
-    return data_[index];
+    return view()(index);
   }
 
   template <typename... OtherIndices>
-  requires(sizeof...(OtherIndices) > 0) constexpr auto
+  requires(sizeof...(OtherIndices) == NumDims - 1) constexpr T
   operator()(size_t index, OtherIndices... others) const {
-    check_input(index);
-    return data_[index](others...);
+    return data_[offset<bounds_checked>(index, others...)];
   }
 
   template <typename... OtherIndices>
-  requires(sizeof...(OtherIndices) > 0) constexpr auto &
+  requires(sizeof...(OtherIndices) == NumDims - 1) constexpr T &
   operator()(size_t index, OtherIndices... others) {
-    check_input(index);
-    return data_[index](others...);
+    return data_[offset<bounds_checked>(index, others...)];
   }
 
-  constexpr size_t length() const { return length_; }
+  template <typename... OtherIndices>
+  requires(sizeof...(OtherIndices) > 0 &&
+           sizeof...(OtherIndices) < NumDims - 1) constexpr auto
+  operator()(size_t index, OtherIndices... others) const {
+    return (*this)(index)(others...);
+  }
 
-  constexpr void fill(T value) {
-    for (size_t index = static_cast<size_t>(0); index < length_; ++index) {
-      data_[index].fill(value);
-    }
+  template <typename... OtherIndices>
+  requires(sizeof...(OtherIndices) > 0 &&
+           sizeof...(OtherIndices) < NumDims - 1) constexpr auto
+  operator()(size_t index, OtherIndices... others) {
+    return (*this)(index)(others...);
   }
 
-  constexpr void fill(const InitializerList &values) {
-    if (length_ == static_cast<size_t>(0)) {
-      allocate(values.size());
-    }
-    if (values.size() != length_) {
-      throw MismatchedLength(length_, values.size());
-    }
-    size_t index = static_cast<size_t>(0);
-    for (typename SubArray::InitializerList value : values) {
-      data_[index].fill(value);
-      ++index;
+  constexpr typename SubArray::ConstView at(size_t index) const {
+    check_bounds(index);
+    return view()(index);
+  }
+
+  constexpr typename SubArray::View at(size_t index) {
+    check_bounds(index);
+    return view()(index);
+  }
+
+  template <typename... OtherIndices>
+  requires(sizeof...(OtherIndices) == NumDims - 1) constexpr T
+      at(size_t index, OtherIndices... others) const {
+    return data_[offset<true>(index, others...)];
+  }
+
+  template <typename... OtherIndices>
+  requires(sizeof...(OtherIndices) == NumDims - 1) constexpr T &
+      at(size_t index, OtherIndices... others) {
+    return data_[offset<true>(index, others...)];
+  }
+
+  template <typename... OtherIndices>
+  requires(sizeof...(OtherIndices) > 0 &&
+           sizeof...(OtherIndices) < NumDims - 1) constexpr auto
+      at(size_t index, OtherIndices... others) const {
+    return at(index).at(others...);
+  }
+
+  template <typename... OtherIndices>
+  requires(sizeof...(OtherIndices) > 0 &&
+           sizeof...(OtherIndices) < NumDims - 1) constexpr auto
+      at(size_t index, OtherIndices... others) {
+    return at(index).at(others...);
+  }
+
+  constexpr typename SubArray::View column(size_t index)
+      requires(NumDims == static_cast<size_t>(2)) {
+    return view().column(index);
+  }
+
+  constexpr typename SubArray::ConstView column(size_t index) const
+      requires(NumDims == static_cast<size_t>(2)) {
+    return view().column(index);
+  }
+
+  constexpr View block(size_t row, size_t column, size_t rows,
+                       size_t columns) requires(NumDims ==
+                                                static_cast<size_t>(2)) {
+    return view().block(row, column, rows, columns);
+  }
+
+  constexpr ConstView block(size_t row, size_t column, size_t rows,
+                            size_t columns) const
+      requires(NumDims == static_cast<size_t>(2)) {
+    return view().block(row, column, rows, columns);
+  }
+
+  constexpr View view() { return View(data_, shape_, strides_); }
+
+  constexpr ConstView view() const {
+    return ConstView(data_, shape_, strides_);
+  }
+
+  constexpr size_t length() const { return shape_[0]; }
+
+  constexpr size_t shape(size_t dim) const { return shape_[dim]; }
+
+  constexpr size_t stride(size_t dim) const { return strides_[dim]; }
+
+  // Elements in the buffer, including any row padding.
+  constexpr size_t size() const { return size_; }
+
+  constexpr Layout layout() const { return layout_; }
+
+  constexpr RowPadding padding() const { return padding_; }
+
+  constexpr T *data() { return data_; }
+
+  constexpr const T *data() const { return data_; }
+
+  constexpr void fill(T value) {
+    for (size_t index = static_cast<size_t>(0); index < size_; ++index) {
+      data_[index] = value;
     }
   }
 
-  constexpr void allocate(size_t _length) {
-    if (length_ > static_cast<size_t>(0)) {
-      delete[] data_;
+  constexpr void fill(const InitializerList &values) {
+    if (shape_[0] == static_cast<size_t>(0)) {
+      size_t shape[NumDims] = {};
+      read_shape(values, shape);
+      allocate_shape(shape);
     }
-    data_ = new SubArray[_length];
-    length_ = _length;
+    copy_values(values, data_, shape_, strides_);
   }
 
   template <typename... OtherLengths>
   requires(sizeof...(OtherLengths) ==
            (NumDims - 1)) constexpr void allocate(size_t _length,
                                                   OtherLengths... others) {
-    allocate(_length);
-    for (size_t index = static_cast<size_t>(0); index < length_; ++index) {
-      data_[index].allocate(others...);
-    }
+    const size_t shape[NumDims] = {_length, static_cast<size_t>(others)...};
+    allocate_shape(shape);
   }
 
   constexpr void allocate_like(const DynamicArray &array) {
-    allocate(array.length());
-    for (size_t index = static_cast<size_t>(0); index < length_; ++index) {
-      data_[index].allocate_like(array(index));
+    layout_ = array.layout_;
+    padding_ = array.padding_;
+    allocate_shape(array.shape_);
+  }
+
+  template <ArrayLike Array> constexpr void allocate_like(const Array &array) {
+    size_t shape[NumDims];
+    for (size_t dim = static_cast<size_t>(0); dim < NumDims; ++dim) {
+      shape[dim] = array.shape(dim);
+    }
+    allocate_shape(shape);
+  }
+
+  // Reuses the existing buffer when it already holds as many elements.
+  constexpr DynamicArray &operator=(const DynamicArray &array) {
+    if (this != &array) {
+      allocate_like(array);
+      copy_elements(array);
+    }
+    return *this;
+  }
+
+  constexpr DynamicArray &operator=(DynamicArray &&array) noexcept {
+    swap(array);
+    return *this;
+  }
+
+  // Elementwise expressions are evaluated straight into the existing buffer
+  // when the shapes match.
+  template <ArrayLike Array>
+  requires(!is_same<Array, DynamicArray>::value &&
+           is_same<typename array_traits<Array>::ArrayType,
+                   DynamicArray>::value) constexpr DynamicArray &
+  operator=(const Array &array) {
+    bool same_shape = true;
+    for (size_t dim = static_cast<size_t>(0); dim < NumDims; ++dim) {
+      same_shape = same_shape && (shape_[dim] == array.shape(dim));
     }
+    if (same_shape) {
+      sabai::assign(*this, array);
+    } else {
+      *this = DynamicArray(array);
+    }
+    return *this;
   }
 
-  constexpr void operator=(const DynamicArray &array) { fill(array); }
+  constexpr void swap(DynamicArray &array) noexcept {
+    for (size_t dim = static_cast<size_t>(0); dim < NumDims; ++dim) {
+      std::swap(shape_[dim], array.shape_[dim]);
+      std::swap(strides_[dim], array.strides_[dim]);
+    }
+    std::swap(size_, array.size_);
+    std::swap(layout_, array.layout_);
+    std::swap(padding_, array.padding_);
+    std::swap(resource_, array.resource_);
+    std::swap(data_, array.data_);
+  }
 
   constexpr DynamicArray
   operator()(const DynamicArray<size_t, 1> &indices) const {
+    size_t shape[NumDims];
+    shape[0] = indices.length();
+    for (size_t dim = static_cast<size_t>(1); dim < NumDims; ++dim) {
+      shape[dim] = shape_[dim];
+    }
     DynamicArray indexed;
-    indexed.allocate(indices.length());
+    indexed.layout_ = layout_;
+    indexed.padding_ = padding_;
+    indexed.allocate_shape(shape);
+    const size_t row_size = strides_[0];
     for (size_t index = static_cast<size_t>(0); index < indices.length();
          ++index) {
-      indexed(index) = data_[indices(index)];
+      const size_t row = indices(index);
+      check_bounds(row);
+      if (layout_ != Layout::RowMajor) {
+        sabai::assign(indexed.view()(index), view()(row));
+        continue;
+      }
+      for (size_t element = static_cast<size_t>(0); element < row_size;
+           ++element) {
+        indexed.data_[index * row_size + element] =
+            data_[row * row_size + element];
+      }
     }
     return indexed;
   }
 };
 
+template <typename T, size_t Dim> struct array_traits<DynamicArray<T, Dim>> {
+  using ValueType = T;
+  using ArrayType = DynamicArray<T, Dim>;
+  static constexpr size_t NumDims = Dim;
+};
+
+template <typename T, size_t Dim>
+struct array_traits<DynamicArrayView<T, Dim>> {
+  using ValueType = std::remove_const_t<T>;
+  using ArrayType = DynamicArray<ValueType, Dim>;
+  static constexpr size_t NumDims = Dim;
+};
+
 template <size_t NumDims> using DynamicArrayi = DynamicArray<int, NumDims>;
 
 template <size_t NumDims> using DynamicArrayf = DynamicArray<float, NumDims>;
 
 template <size_t NumDims> using DynamicArrayd = DynamicArray<double, NumDims>;
 
+template <typename T, size_t NumDims>
+constexpr void swap(DynamicArray<T, NumDims> &left,
+                    DynamicArray<T, NumDims> &right) noexcept {
+  left.swap(right);
+}
+
 template <typename T> using DynamicVector = DynamicArray<T, 1>;
 
 using DynamicVectori = DynamicVector<int>;
@@ -327,35 +971,56 @@ empty_like(const DynamicArray<T, NumDims> &array) {
   return empty_array;
 };
 
+template <typename T, size_t NumDims>
+constexpr DynamicArray<std::remove_const_t<T>, NumDims>
+empty_like(const DynamicArrayView<T, NumDims> &array) {
+  DynamicArray<std::remove_const_t<T>, NumDims> empty_array;
+  empty_array.allocate_like(array);
+  return empty_array;
+};
+
+// Views of a rows x columns matrix stored elsewhere, such as a buffer shared
+// with BLAS, LAPACK or Fortran code, without copying it. leading_dimension
+// is the distance between the starts of consecutive rows of a row-major
+// matrix or columns of a column-major one.
 template <typename T>
-constexpr bool all_equal(const DynamicVector<T> &left,
-                         const DynamicVector<T> &right) {
-  if (left.length() != right.length()) {
-    throw MismatchedLength(left.length(), right.length());
-  }
+constexpr DynamicArrayView<T, 2> row_major_view(T *data, size_t rows,
+                                                size_t columns,
+                                                size_t leading_dimension) {
+  const size_t shape[2] = {rows, columns};
+  const size_t strides[2] = {leading_dimension, static_cast<size_t>(1)};
+  return DynamicArrayView<T, 2>(data, shape, strides);
+}
 
-  for (size_t index = static_cast<size_t>(0); index < left.length(); ++index) {
-    if (left(index) != right(index)) {
-      return false;
-    }
-  }
-  return true;
-};
+template <typename T>
+constexpr DynamicArrayView<T, 2> row_major_view(T *data, size_t rows,
+                                                size_t columns) {
+  return row_major_view(data, rows, columns, columns);
+}
 
-template <typename T, size_t NumDims>
-constexpr bool all_equal(const DynamicArray<T, NumDims> &left,
-                         const DynamicArray<T, NumDims> &right) {
-  if (left.length() != right.length()) {
-    throw MismatchedLength(left.length(), right.length());
-  }
+template <typename T>
+constexpr DynamicArrayView<T, 2> column_major_view(T *data, size_t rows,
+                                                   size_t columns,
+                                                   size_t leading_dimension) {
+  const size_t shape[2] = {rows, columns};
+  const size_t strides[2] = {static_cast<size_t>(1), leading_dimension};
+  return DynamicArrayView<T, 2>(data, shape, strides);
+}
 
-  for (size_t index = static_cast<size_t>(0); index < left.length(); ++index) {
-    if (!all_equal(left(index), right(index))) {
-      return false;
-    }
-  }
-  return true;
-};
+template <typename T>
+constexpr DynamicArrayView<T, 2> column_major_view(T *data, size_t rows,
+                                                   size_t columns) {
+  return column_major_view(data, rows, columns, rows);
+}
+
+// A vector viewed as a matrix with a single column.
+template <typename T>
+constexpr DynamicArrayView<T, 2>
+as_column(const DynamicArrayView<T, 1> &vector) {
+  const size_t shape[2] = {vector.length(), static_cast<size_t>(1)};
+  const size_t strides[2] = {vector.stride(0), static_cast<size_t>(1)};
+  return DynamicArrayView<T, 2>(vector.data(), shape, strides);
+}
 
 template <typename T> constexpr DynamicMatrix<T> Identity(size_t N) {
   DynamicMatrix<T> matrix(N, N);
@@ -0,0 +1,341 @@
+#pragma once
+
+#include "sabai/base.hpp"
+#include "sabai/simd.hpp"
+
+#include <type_traits>
+#include <utility>
+
+namespace sabai {
+
+// Each operation also has a form that writes its result through a reference,
+// which the evaluators below use for SIMD packs (see SimdPack).
+struct Negate {
+  template <typename T> constexpr auto operator()(const T &element) const {
+    return -element;
+  }
+
+  template <typename T> void operator()(const T &element, T &result) const {
+    result = -element;
+  }
+};
+
+struct Add {
+  template <typename T, typename U>
+  constexpr auto operator()(const T &left, const U &right) const {
+    return left + right;
+  }
+
+  template <typename T>
+  void operator()(const T &left, const T &right, T &result) const {
+    result = left + right;
+  }
+};
+
+struct Subtract {
+  template <typename T, typename U>
+  constexpr auto operator()(const T &left, const U &right) const {
+    return left - right;
+  }
+
+  template <typename T>
+  void operator()(const T &left, const T &right, T &result) const {
+    result = left - right;
+  }
+};
+
+template <typename T> struct Scale {
+  T value;
+
+  template <typename U> constexpr auto operator()(const U &element) const {
+    return value * element;
+  }
+
+  template <typename U> void operator()(const U &element, U &result) const {
+    result = value * element;
+  }
+};
+
+template <typename T> struct DivideBy {
+  T divisor;
+
+  template <typename U> constexpr auto operator()(const U &element) const {
+    return element / divisor;
+  }
+
+  template <typename U> void operator()(const U &element, U &result) const {
+    result = element / divisor;
+  }
+};
+
+template <typename T> struct DivideInto {
+  T numerator;
+
+  template <typename U> constexpr auto operator()(const U &element) const {
+    return numerator / element;
+  }
+
+  template <typename U> void operator()(const U &element, U &result) const {
+    result = numerator / element;
+  }
+};
+
+// Named arrays are held by reference; temporaries and expressions, which only
+// hold references themselves, are held by value so that nothing dangles.
+template <typename Operand>
+using OperandStorage = std::conditional_t<
+    std::is_lvalue_reference_v<Operand> &&
+        !is_expression<std::remove_cvref_t<Operand>>::value,
+    const std::remove_cvref_t<Operand> &, std::remove_cvref_t<Operand>>;
+
+template <typename Operation, typename Operand> class UnaryExpression {
+public:
+  using ValueType = ValueTypeOf<Operand>;
+  static constexpr size_t NumDims =
+      array_traits<std::remove_cvref_t<Operand>>::NumDims;
+
+private:
+  Operation operation_;
+  OperandStorage<Operand> operand_;
+
+public:
+  constexpr UnaryExpression(Operation operation, Operand &&operand)
+      : operation_(operation), operand_(std::forward<Operand>(operand)) {}
+
+  constexpr const Operation &operation() const { return operation_; }
+
+  constexpr const std::remove_cvref_t<Operand> &operand() const {
+    return operand_;
+  }
+
+  constexpr size_t length() const { return operand_.length(); }
+
+  constexpr size_t shape(size_t dim) const { return operand_.shape(dim); }
+
+  constexpr auto operator()(size_t index) const {
+    if constexpr (NumDims == static_cast<size_t>(1)) {
+      return operation_(operand_(index));
+    } else {
+      return UnaryExpression<Operation, decltype(operand_(index))>(
+          operation_, operand_(index));
+    }
+  }
+};
+
+template <typename Operation, typename Left, typename Right>
+class BinaryExpression {
+public:
+  using ValueType = ValueTypeOf<Left>;
+  static constexpr size_t NumDims =
+      array_traits<std::remove_cvref_t<Left>>::NumDims;
+
+private:
+  Operation operation_;
+  OperandStorage<Left> left_;
+  OperandStorage<Right> right_;
+
+public:
+  constexpr BinaryExpression(Operation operation, Left &&left, Right &&right)
+      : operation_(operation), left_(std::forward<Left>(left)),
+        right_(std::forward<Right>(right)) {
+    if (left_.length() != right_.length()) {
+      throw MismatchedLength(left_.length(), right_.length());
+    }
+  }
+
+  constexpr const Operation &operation() const { return operation_; }
+
+  constexpr const std::remove_cvref_t<Left> &left() const { return left_; }
+
+  constexpr const std::remove_cvref_t<Right> &right() const { return right_; }
+
+  constexpr size_t length() const { return left_.length(); }
+
+  constexpr size_t shape(size_t dim) const { return left_.shape(dim); }
+
+  constexpr auto operator()(size_t index) const {
+    if constexpr (NumDims == static_cast<size_t>(1)) {
+      return operation_(left_(index), right_(index));
+    } else {
+      return BinaryExpression<Operation, decltype(left_(index)),
+                              decltype(right_(index))>(
+          operation_, left_(index), right_(index));
+    }
+  }
+};
+
+template <typename Operation, typename Operand>
+struct array_traits<UnaryExpression<Operation, Operand>>
+    : array_traits<std::remove_cvref_t<Operand>> {};
+
+template <typename Operation, typename Left, typename Right>
+struct array_traits<BinaryExpression<Operation, Left, Right>>
+    : array_traits<std::remove_cvref_t<Left>> {};
+
+template <typename Operation, typename Operand>
+struct is_expression<UnaryExpression<Operation, Operand>> {
+  static constexpr bool value = true;
+};
+
+template <typename Operation, typename Left, typename Right>
+struct is_expression<BinaryExpression<Operation, Left, Right>> {
+  static constexpr bool value = true;
+};
+
+// Evaluates an expression, or copies an array, into its owning ArrayType.
+template <ArrayLike Array>
+constexpr typename array_traits<Array>::ArrayType
+evaluate(const Array &array) {
+  return typename array_traits<Array>::ArrayType(array);
+}
+
+// Evaluators read the leaves of an expression through raw pointers, so an
+// expression over dense float or double arrays is evaluated by the SIMD
+// kernels without indexing or bounds checks.
+template <typename T> struct DenseEvaluator {
+  const T *data;
+
+  template <typename Pack>
+  void packet(size_t index, typename Pack::Type &result) const {
+    result = Pack::load(data + index);
+  }
+
+  T element(size_t index) const { return data[index]; }
+};
+
+template <typename Operation, typename Operand> struct UnaryEvaluator {
+  Operation operation;
+  Operand operand;
+
+  template <typename Pack>
+  void packet(size_t index, typename Pack::Type &result) const {
+    operand.template packet<Pack>(index, result);
+    operation(result, result);
+  }
+
+  auto element(size_t index) const {
+    return operation(operand.element(index));
+  }
+};
+
+template <typename Operation, typename Left, typename Right>
+struct BinaryEvaluator {
+  Operation operation;
+  Left left;
+  Right right;
+
+  template <typename Pack>
+  void packet(size_t index, typename Pack::Type &result) const {
+    typename Pack::Type right_packet;
+    left.template packet<Pack>(index, result);
+    right.template packet<Pack>(index, right_packet);
+    operation(result, right_packet, result);
+  }
+
+  auto element(size_t index) const {
+    return operation(left.element(index), right.element(index));
+  }
+};
+
+// The elements of a vector with unit stride, or nullptr.
+template <typename T, VectorLike Vector>
+constexpr T *contiguous_data(Vector &&vector) {
+  if constexpr (!is_same<ValueTypeOf<Vector>, std::remove_const_t<T>>::value) {
+    return nullptr;
+  } else if constexpr (requires { vector.stride(0); }) {
+    return vector.stride(0) == static_cast<size_t>(1) ? vector.data()
+                                                      : nullptr;
+  } else if constexpr (requires { vector.data(); }) {
+    return vector.data();
+  } else {
+    return nullptr;
+  }
+}
+
+// The elements of array stored densely in the same order as those of result,
+// or nullptr. Arrays of more than one dimension qualify only when they own
+// their storage and have the same type, shape and layout as result, which
+// may include row padding.
+template <typename T, typename Result, ArrayLike Array>
+constexpr T *dense_data(const Result &result, Array &&array) {
+  using Owning = typename array_traits<std::remove_cvref_t<Result>>::ArrayType;
+  if constexpr (array_traits<std::remove_cvref_t<Array>>::NumDims ==
+                static_cast<size_t>(1)) {
+    return contiguous_data<T>(array);
+  } else if constexpr (!is_same<std::remove_cvref_t<Array>, Owning>::value) {
+    return nullptr;
+  } else {
+    if constexpr (requires { array.shape(0); }) {
+      for (size_t dim = static_cast<size_t>(0);
+           dim < array_traits<Owning>::NumDims; ++dim) {
+        if (array.shape(dim) != result.shape(dim) ||
+            array.stride(dim) != result.stride(dim)) {
+          return nullptr;
+        }
+      }
+    }
+    return array.data();
+  }
+}
+
+template <typename T, typename Result, ArrayLike Array>
+constexpr bool is_dense(const Result &result, const Array &array) {
+  if constexpr (!is_expression<Array>::value) {
+    return dense_data<const T>(result, array) != nullptr;
+  } else if constexpr (requires { array.operand(); }) {
+    return is_dense<T>(result, array.operand());
+  } else {
+    return is_dense<T>(result, array.left()) &&
+           is_dense<T>(result, array.right());
+  }
+}
+
+template <typename T, typename Result, ArrayLike Array>
+constexpr auto dense_evaluator(const Result &result, const Array &array) {
+  if constexpr (!is_expression<Array>::value) {
+    return DenseEvaluator<T>{dense_data<const T>(result, array)};
+  } else if constexpr (requires { array.operand(); }) {
+    auto operand = dense_evaluator<T>(result, array.operand());
+    return UnaryEvaluator<std::remove_cvref_t<decltype(array.operation())>,
+                          decltype(operand)>{array.operation(), operand};
+  } else {
+    auto left = dense_evaluator<T>(result, array.left());
+    auto right = dense_evaluator<T>(result, array.right());
+    return BinaryEvaluator<std::remove_cvref_t<decltype(array.operation())>,
+                           decltype(left), decltype(right)>{
+        array.operation(), left, right};
+  }
+}
+
+// Writes the elements of array, which may be an expression, into result.
+// Float and double results whose operands are all dense take a single SIMD
+// pass; everything else is copied element by element.
+template <typename Result, ArrayLike Array>
+constexpr void assign(Result &&result, const Array &array) {
+  if (result.length() != array.length()) {
+    throw MismatchedLength(result.length(), array.length());
+  }
+  using T = ValueTypeOf<Result>;
+  if constexpr (is_simd_type<T>::value) {
+    if (!std::is_constant_evaluated()) {
+      T *data = dense_data<T>(result, result);
+      if (data != nullptr && is_dense<T>(result, array)) {
+        size_t size = result.length();
+        if constexpr (requires { result.size(); }) {
+          size = result.size();
+        }
+        simd_evaluate(size, data, dense_evaluator<T>(result, array));
+        return;
+      }
+    }
+  }
+  for (size_t index = static_cast<size_t>(0); index < array.length();
+       ++index) {
+    if constexpr (array_traits<Array>::NumDims == static_cast<size_t>(1)) {
+      result(index) = array(index);
+    } else {
+      assign(result(index), array(index));
+    }
+  }
+}
+} // namespace sabai
@@ -0,0 +1,285 @@
+#pragma once
+
+#include "sabai/base.hpp"
+#include "sabai/dynamic.hpp"
+#include "sabai/simd.hpp"
+#include "sabai/thread_pool.hpp"
+
+#include <algorithm>
+
+namespace sabai {
+
+// Block sizes of the packed matrix product. An MR x NR tile of the result is
+// accumulated in registers, a KC x NR micro-panel of the right operand stays
+// in L1 and an MC x KC block of the left operand stays in L2.
+template <typename T> struct GemmBlocking {
+  static constexpr size_t MR = static_cast<size_t>(4);
+  static constexpr size_t NR = static_cast<size_t>(8);
+  static constexpr size_t KC = static_cast<size_t>(256);
+  static constexpr size_t MC = static_cast<size_t>(128);
+  static constexpr size_t NC = static_cast<size_t>(4096);
+  // Products with fewer multiply-adds than this stay on the calling thread.
+  static constexpr size_t parallel_threshold = static_cast<size_t>(1) << 18;
+};
+
+constexpr size_t round_up(size_t value, size_t multiple) {
+  return (value + multiple - static_cast<size_t>(1)) / multiple * multiple;
+}
+
+// Copies an mc x kc block of A into row panels of height MR, stored column by
+// column and padded with zeros, so the micro-kernel reads it sequentially.
+template <typename T>
+void pack_left(const T *a, size_t row_stride, size_t column_stride, size_t mc,
+               size_t kc, T *packed) {
+  constexpr size_t MR = GemmBlocking<T>::MR;
+  for (size_t panel = static_cast<size_t>(0); panel < mc; panel += MR) {
+    const size_t rows = std::min(MR, mc - panel);
+    const T *panel_start = a + panel * row_stride;
+    for (size_t k = static_cast<size_t>(0); k < kc; ++k) {
+      size_t row = static_cast<size_t>(0);
+      for (; row < rows; ++row) {
+        *packed++ = panel_start[row * row_stride + k * column_stride];
+      }
+      for (; row < MR; ++row) {
+        *packed++ = static_cast<T>(0);
+      }
+    }
+  }
+}
+
+// Copies a kc x nc block of B into column panels of width NR, stored row by
+// row and padded with zeros.
+template <typename T>
+void pack_right(const T *b, size_t row_stride, size_t column_stride,
+                size_t kc, size_t nc, T *packed) {
+  constexpr size_t NR = GemmBlocking<T>::NR;
+  for (size_t panel = static_cast<size_t>(0); panel < nc; panel += NR) {
+    const size_t columns = std::min(NR, nc - panel);
+    const T *panel_start = b + panel * column_stride;
+    for (size_t k = static_cast<size_t>(0); k < kc; ++k) {
+      size_t column = static_cast<size_t>(0);
+      for (; column < columns; ++column) {
+        *packed++ = panel_start[k * row_stride + column * column_stride];
+      }
+      for (; column < NR; ++column) {
+        *packed++ = static_cast<T>(0);
+      }
+    }
+  }
+}
+
+// Computes C += alpha * A * B for one MR x NR tile from packed panels. Only
+// the leading rows x columns of the tile are written back.
+template <typename T>
+void gemm_micro_kernel(size_t kc, T alpha, const T *a, const T *b, T *c,
+                       size_t row_stride, size_t column_stride, size_t rows,
+                       size_t columns) {
+  constexpr size_t MR = GemmBlocking<T>::MR;
+  constexpr size_t NR = GemmBlocking<T>::NR;
+  T accumulator[MR * NR] = {};
+  for (size_t k = static_cast<size_t>(0); k < kc; ++k) {
+    for (size_t row = static_cast<size_t>(0); row < MR; ++row) {
+      const T a_value = a[row];
+      for (size_t column = static_cast<size_t>(0); column < NR; ++column) {
+        accumulator[row * NR + column] += a_value * b[column];
+      }
+    }
+    a += MR;
+    b += NR;
+  }
+  for (size_t row = static_cast<size_t>(0); row < rows; ++row) {
+    for (size_t column = static_cast<size_t>(0); column < columns; ++column) {
+      c[row * row_stride + column * column_stride] +=
+          alpha * accumulator[row * NR + column];
+    }
+  }
+}
+
+// An empty buffer bound to the heap. Thread-local buffers outlive any
+// MemoryResourceScope active when they are first used, so they must not
+// take their memory from it.
+template <typename T> DynamicArray<T, 1> heap_buffer() {
+  const MemoryResourceScope heap(heap_resource());
+  return DynamicArray<T, 1>();
+}
+
+// The single-threaded blocked product behind gemm, for operands whose shapes
+// have already been checked.
+template <typename T>
+void gemm_blocked(T alpha, const DynamicArrayView<const T, 2> &a,
+                  const DynamicArrayView<const T, 2> &b, T beta,
+                  const DynamicArrayView<T, 2> &c) {
+  constexpr size_t MR = GemmBlocking<T>::MR;
+  constexpr size_t NR = GemmBlocking<T>::NR;
+  constexpr size_t KC = GemmBlocking<T>::KC;
+  constexpr size_t MC = GemmBlocking<T>::MC;
+  constexpr size_t NC = GemmBlocking<T>::NC;
+
+  const size_t m = a.shape(0);
+  const size_t k = a.shape(1);
+  const size_t n = b.shape(1);
+
+  if (beta == static_cast<T>(0)) {
+    c.fill(static_cast<T>(0));
+  } else if (beta != static_cast<T>(1)) {
+    for (size_t row = static_cast<size_t>(0); row < m; ++row) {
+      T *c_row = c.data() + row * c.stride(0);
+      for (size_t column = static_cast<size_t>(0); column < n; ++column) {
+        c_row[column * c.stride(1)] *= beta;
+      }
+    }
+  }
+  if (k == static_cast<size_t>(0) || alpha == static_cast<T>(0)) {
+    return;
+  }
+
+  thread_local DynamicArray<T, 1> packed_a = heap_buffer<T>();
+  thread_local DynamicArray<T, 1> packed_b = heap_buffer<T>();
+  const size_t packed_a_size = round_up(std::min(MC, m), MR) * std::min(KC, k);
+  const size_t packed_b_size = round_up(std::min(NC, n), NR) * std::min(KC, k);
+  if (packed_a.length() < packed_a_size) {
+    packed_a.allocate(packed_a_size);
+  }
+  if (packed_b.length() < packed_b_size) {
+    packed_b.allocate(packed_b_size);
+  }
+
+  for (size_t jc = static_cast<size_t>(0); jc < n; jc += NC) {
+    const size_t nc = std::min(NC, n - jc);
+    for (size_t pc = static_cast<size_t>(0); pc < k; pc += KC) {
+      const size_t kc = std::min(KC, k - pc);
+      pack_right(b.data() + pc * b.stride(0) + jc * b.stride(1), b.stride(0),
+                 b.stride(1), kc, nc, packed_b.data());
+      for (size_t ic = static_cast<size_t>(0); ic < m; ic += MC) {
+        const size_t mc = std::min(MC, m - ic);
+        pack_left(a.data() + ic * a.stride(0) + pc * a.stride(1),
+                  a.stride(0), a.stride(1), mc, kc, packed_a.data());
+        for (size_t jr = static_cast<size_t>(0); jr < nc; jr += NR) {
+          for (size_t ir = static_cast<size_t>(0); ir < mc; ir += MR) {
+            gemm_micro_kernel(
+                kc, alpha, packed_a.data() + ir * kc,
+                packed_b.data() + jr * kc,
+                c.data() + (ic + ir) * c.stride(0) + (jc + jr) * c.stride(1),
+                c.stride(0), c.stride(1), std::min(MR, mc - ir),
+                std::min(NR, nc - jr));
+          }
+        }
+      }
+    }
+  }
+}
+
+// General matrix product C = alpha * A * B + beta * C on strided views, so
+// blocks, columns and transposed views can be used without copying. When
+// beta is zero C is overwritten and its previous contents are ignored. Large
+// products are split into disjoint row or column bands of C across the
+// thread pool.
+template <typename T>
+void gemm(T alpha, const DynamicArrayView<const T, 2> &a,
+          const DynamicArrayView<const T, 2> &b, T beta,
+          const DynamicArrayView<T, 2> &c) {
+  const size_t m = a.shape(0);
+  const size_t k = a.shape(1);
+  const size_t n = b.shape(1);
+  if (b.shape(0) != k) {
+    throw MismatchedLength(k, b.shape(0));
+  }
+  if (c.shape(0) != m) {
+    throw MismatchedLength(c.shape(0), m);
+  }
+  if (c.shape(1) != n) {
+    throw MismatchedLength(c.shape(1), n);
+  }
+
+  if (m * n * k < GemmBlocking<T>::parallel_threshold ||
+      thread_pool().size() == static_cast<size_t>(1)) {
+    gemm_blocked(alpha, a, b, beta, c);
+  } else if (m >= n) {
+    thread_pool().parallel_for(
+        m, GemmBlocking<T>::MR, [&](size_t begin, size_t end) {
+          gemm_blocked(alpha, a.block(begin, 0, end - begin, k), b, beta,
+                       c.block(begin, 0, end - begin, n));
+        });
+  } else {
+    thread_pool().parallel_for(
+        n, GemmBlocking<T>::NR, [&](size_t begin, size_t end) {
+          gemm_blocked(alpha, a, b.block(0, begin, k, end - begin), beta,
+                       c.block(0, begin, m, end - begin));
+        });
+  }
+}
+
+// Rows of the matrix-vector product computed per task, and the number of
+// multiply-adds below which it stays on the calling thread.
+template <typename T> struct GemvBlocking {
+  static constexpr size_t rows = static_cast<size_t>(64);
+  static constexpr size_t parallel_threshold = static_cast<size_t>(1) << 16;
+};
+
+// Matrix-vector product y = alpha * A * x + beta * y on strided views. When
+// beta is zero y is overwritten. Row-major A takes a dot product per row;
+// column-major A, including the transpose of a row-major matrix, adds a
+// multiple of each contiguous column to y instead. Large products split the
+// rows of A across the thread pool.
+template <typename T>
+void gemv(T alpha, const DynamicArrayView<const T, 2> &a,
+          const DynamicArrayView<const T, 1> &x, T beta,
+          const DynamicArrayView<T, 1> &y) {
+  const size_t m = a.shape(0);
+  const size_t n = a.shape(1);
+  if (x.length() != n) {
+    throw MismatchedLength(n, x.length());
+  }
+  if (y.length() != m) {
+    throw MismatchedLength(y.length(), m);
+  }
+
+  const bool contiguous = is_simd_type<T>::value &&
+                          a.stride(1) == static_cast<size_t>(1) &&
+                          x.stride(0) == static_cast<size_t>(1);
+  const bool column_major = a.stride(0) == static_cast<size_t>(1) &&
+                            a.stride(1) != static_cast<size_t>(1);
+  auto columns = [&](size_t begin, size_t end) {
+    T *y_data = y.data();
+    const size_t y_stride = y.stride(0);
+    for (size_t row = begin; row < end; ++row) {
+      y_data[row * y_stride] = beta == static_cast<T>(0)
+                                   ? static_cast<T>(0)
+                                   : beta * y_data[row * y_stride];
+    }
+    for (size_t column = static_cast<size_t>(0); column < n; ++column) {
+      const T factor = alpha * x.data()[column * x.stride(0)];
+      const T *a_column = a.data() + column * a.stride(1);
+      for (size_t row = begin; row < end; ++row) {
+        y_data[row * y_stride] += factor * a_column[row];
+      }
+    }
+  };
+  auto rows = [&](size_t begin, size_t end) {
+    if (column_major) {
+      columns(begin, end);
+      return;
+    }
+    for (size_t row = begin; row < end; ++row) {
+      const T *a_row = a.data() + row * a.stride(0);
+      T value = static_cast<T>(0);
+      if (contiguous) {
+        value = simd_dot(n, a_row, x.data());
+      } else {
+        for (size_t column = static_cast<size_t>(0); column < n; ++column) {
+          value +=
+              a_row[column * a.stride(1)] * x.data()[column * x.stride(0)];
+        }
+      }
+      T &result = y.data()[row * y.stride(0)];
+      result = beta == static_cast<T>(0) ? alpha * value
+                                         : alpha * value + beta * result;
+    }
+  };
+  if (m * n < GemvBlocking<T>::parallel_threshold) {
+    rows(static_cast<size_t>(0), m);
+  } else {
+    thread_pool().parallel_for(m, GemvBlocking<T>::rows, rows);
+  }
+}
+} // namespace sabai
@@ -7,6 +7,9 @@ namespace sabai {
 
 template <typename T> DynamicMatrix<T> triu(const DynamicMatrix<T> &matrix) {
   const size_t N = matrix.length();
+  if (matrix.shape(1) != N) {
+    throw MismatchedLength(N, matrix.shape(1));
+  }
   DynamicMatrix<T> upper_triangular(N, N);
   const auto zero_element = static_cast<T>(0);
   for (size_t row = static_cast<size_t>(0); row < N; ++row) {
@@ -37,6 +40,9 @@ StaticMatrix<T, N, N> triu(const StaticMatrix<T, N, N> &matrix) {
 
 template <typename T> DynamicMatrix<T> tril(const DynamicMatrix<T> &matrix) {
   const size_t N = matrix.length();
+  if (matrix.shape(1) != N) {
+    throw MismatchedLength(N, matrix.shape(1));
+  }
   DynamicMatrix<T> lower_triangular(N, N);
   const auto zero_element = static_cast<T>(0);
   for (size_t row = static_cast<size_t>(0); row < N; ++row) {
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "sabai/decompositions.hpp"
+#include "sabai/static.hpp"
+
+#include <limits>
+
+namespace sabai {
+
+// Closed-form determinants, adjugates, inverses and solves for 2x2, 3x3 and
+// 4x4 static matrices. They are straight-line arithmetic, so they vectorize
+// when applied across a batch, and adjugate and determinant can be evaluated
+// at compile time. inverse and solve fall back to a pivoted LUDecomposition
+// near singularity, so they run at run time only.
+
+template <size_t N>
+inline constexpr bool has_closed_form = N == static_cast<size_t>(2) ||
+                                        N == static_cast<size_t>(3) ||
+                                        N == static_cast<size_t>(4);
+
+// The transposed cofactor matrix, so that A adjugate(A) = det(A) I.
+template <typename T, size_t N>
+requires(has_closed_form<N>) constexpr StaticMatrix<T, N, N>
+adjugate(const StaticMatrix<T, N, N> &A) {
+  StaticMatrix<T, N, N> B;
+  if constexpr (N == static_cast<size_t>(2)) {
+    B(0, 0) = A(1, 1);
+    B(0, 1) = -A(0, 1);
+    B(1, 0) = -A(1, 0);
+    B(1, 1) = A(0, 0);
+  } else if constexpr (N == static_cast<size_t>(3)) {
+    B(0, 0) = A(1, 1) * A(2, 2) - A(1, 2) * A(2, 1);
+    B(0, 1) = A(0, 2) * A(2, 1) - A(0, 1) * A(2, 2);
+    B(0, 2) = A(0, 1) * A(1, 2) - A(0, 2) * A(1, 1);
+    B(1, 0) = A(1, 2) * A(2, 0) - A(1, 0) * A(2, 2);
+    B(1, 1) = A(0, 0) * A(2, 2) - A(0, 2) * A(2, 0);
+    B(1, 2) = A(0, 2) * A(1, 0) - A(0, 0) * A(1, 2);
+    B(2, 0) = A(1, 0) * A(2, 1) - A(1, 1) * A(2, 0);
+    B(2, 1) = A(0, 1) * A(2, 0) - A(0, 0) * A(2, 1);
+    B(2, 2) = A(0, 0) * A(1, 1) - A(0, 1) * A(1, 0);
+  } else {
+    // 2x2 minors of the top two rows (s) and the bottom two rows (c).
+    const T s0 = A(0, 0) * A(1, 1) - A(1, 0) * A(0, 1);
+    const T s1 = A(0, 0) * A(1, 2) - A(1, 0) * A(0, 2);
+    const T s2 = A(0, 0) * A(1, 3) - A(1, 0) * A(0, 3);
+    const T s3 = A(0, 1) * A(1, 2) - A(1, 1) * A(0, 2);
+    const T s4 = A(0, 1) * A(1, 3) - A(1, 1) * A(0, 3);
+    const T s5 = A(0, 2) * A(1, 3) - A(1, 2) * A(0, 3);
+    const T c0 = A(2, 0) * A(3, 1) - A(3, 0) * A(2, 1);
+    const T c1 = A(2, 0) * A(3, 2) - A(3, 0) * A(2, 2);
+    const T c2 = A(2, 0) * A(3, 3) - A(3, 0) * A(2, 3);
+    const T c3 = A(2, 1) * A(3, 2) - A(3, 1) * A(2, 2);
+    const T c4 = A(2, 1) * A(3, 3) - A(3, 1) * A(2, 3);
+    const T c5 = A(2, 2) * A(3, 3) - A(3, 2) * A(2, 3);
+    B(0, 0) = A(1, 1) * c5 - A(1, 2) * c4 + A(1, 3) * c3;
+    B(0, 1) = -A(0, 1) * c5 + A(0, 2) * c4 - A(0, 3) * c3;
+    B(0, 2) = A(3, 1) * s5 - A(3, 2) * s4 + A(3, 3) * s3;
+    B(0, 3) = -A(2, 1) * s5 + A(2, 2) * s4 - A(2, 3) * s3;
+    B(1, 0) = -A(1, 0) * c5 + A(1, 2) * c2 - A(1, 3) * c1;
+    B(1, 1) = A(0, 0) * c5 - A(0, 2) * c2 + A(0, 3) * c1;
+    B(1, 2) = -A(3, 0) * s5 + A(3, 2) * s2 - A(3, 3) * s1;
+    B(1, 3) = A(2, 0) * s5 - A(2, 2) * s2 + A(2, 3) * s1;
+    B(2, 0) = A(1, 0) * c4 - A(1, 1) * c2 + A(1, 3) * c0;
+    B(2, 1) = -A(0, 0) * c4 + A(0, 1) * c2 - A(0, 3) * c0;
+    B(2, 2) = A(3, 0) * s4 - A(3, 1) * s2 + A(3, 3) * s0;
+    B(2, 3) = -A(2, 0) * s4 + A(2, 1) * s2 - A(2, 3) * s0;
+    B(3, 0) = -A(1, 0) * c3 + A(1, 1) * c1 - A(1, 2) * c0;
+    B(3, 1) = A(0, 0) * c3 - A(0, 1) * c1 + A(0, 2) * c0;
+    B(3, 2) = -A(3, 0) * s3 + A(3, 1) * s1 - A(3, 2) * s0;
+    B(3, 3) = A(2, 0) * s3 - A(2, 1) * s1 + A(2, 2) * s0;
+  }
+  return B;
+}
+
+// Expands along the first row, reusing the first column of the adjugate.
+template <typename T, size_t N>
+requires(has_closed_form<N>) constexpr T
+determinant(const StaticMatrix<T, N, N> &A,
+            const StaticMatrix<T, N, N> &adjugate_of_A) {
+  T result = static_cast<T>(0);
+  for (size_t j = static_cast<size_t>(0); j < N; ++j) {
+    result += A(0, j) * adjugate_of_A(j, 0);
+  }
+  return result;
+}
+
+template <typename T, size_t N>
+requires(has_closed_form<N>) constexpr T
+determinant(const StaticMatrix<T, N, N> &A) {
+  return determinant(A, adjugate(A));
+}
+
+// Whether det is large enough, relative to A, for the adjugate formulas to
+// be accurate. By Hadamard's inequality |det(A)| is at most the product of
+// the row norms, with equality for orthogonal rows; the closed forms are
+// used while the ratio is above sqrt(epsilon). Each row is first divided by
+// its largest magnitude, which leaves the ratio unchanged and keeps both
+// sides between 0 and N^N, so large entries cannot overflow the squares.
+template <typename T, size_t N>
+constexpr bool closed_form_conditioned(const StaticMatrix<T, N, N> &A,
+                                       T determinant_of_A) {
+  const auto magnitude = [](T value) {
+    return value < static_cast<T>(0) ? -value : value;
+  };
+  // An overflowed or NaN determinant fails here too.
+  if (!(magnitude(determinant_of_A) <= std::numeric_limits<T>::max())) {
+    return false;
+  }
+  T ratio = determinant_of_A;
+  T bound = static_cast<T>(1);
+  for (size_t i = static_cast<size_t>(0); i < N; ++i) {
+    T row_max = static_cast<T>(0);
+    for (size_t j = static_cast<size_t>(0); j < N; ++j) {
+      if (magnitude(A(i, j)) > row_max) {
+        row_max = magnitude(A(i, j));
+      }
+    }
+    if (row_max == static_cast<T>(0)) {
+      return false;
+    }
+    T row_norm = static_cast<T>(0);
+    for (size_t j = static_cast<size_t>(0); j < N; ++j) {
+      const T scaled = A(i, j) / row_max;
+      row_norm += scaled * scaled;
+    }
+    ratio /= row_max;
+    bound *= row_norm;
+  }
+  return ratio * ratio > std::numeric_limits<T>::epsilon() * bound;
+}
+
+// A^-1 from the adjugate, or from a pivoted LUDecomposition when A is too
+// close to singular for the closed form.
+template <typename T, size_t N>
+requires(has_closed_form<N>) StaticMatrix<T, N, N>
+inverse(const StaticMatrix<T, N, N> &A) {
+  StaticMatrix<T, N, N> B = adjugate(A);
+  const T det = determinant(A, B);
+  if (!closed_form_conditioned(A, det)) {
+    return solve(LUDecomposition<T, N, N>(A), Identity<T, N>());
+  }
+  const T scale = static_cast<T>(1) / det;
+  for (size_t i = static_cast<size_t>(0); i < N; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < N; ++j) {
+      B(i, j) *= scale;
+    }
+  }
+  return B;
+}
+
+// Solves A x = b as adjugate(A) b / det(A), with the same fallback as
+// inverse.
+template <typename T, size_t N>
+requires(has_closed_form<N>) StaticVector<T, N>
+solve(const StaticMatrix<T, N, N> &A, const StaticVector<T, N> &b) {
+  const StaticMatrix<T, N, N> B = adjugate(A);
+  const T det = determinant(A, B);
+  if (!closed_form_conditioned(A, det)) {
+    return solve(LUDecomposition<T, N, N>(A), b);
+  }
+  const T scale = static_cast<T>(1) / det;
+  StaticVector<T, N> x;
+  for (size_t i = static_cast<size_t>(0); i < N; ++i) {
+    T sum = static_cast<T>(0);
+    for (size_t j = static_cast<size_t>(0); j < N; ++j) {
+      sum += B(i, j) * b(j);
+    }
+    x(i) = sum * scale;
+  }
+  return x;
+}
+} // namespace sabai
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "sabai/base.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+namespace sabai {
+
+// Allocates through the global operator new(size_t), like new T[] did, so
+// replacing operator new still sees every array. Alignments beyond what
+// operator new guarantees are met by over-allocating and keeping the start
+// of the block just before the aligned address, rather than with the
+// aligned overloads that a replaced operator new(size_t) does not cover.
+class HeapResource : public std::pmr::memory_resource {
+private:
+  static constexpr size_t new_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    if (alignment <= new_alignment) {
+      return ::operator new(bytes);
+    }
+    // The block is aligned to new_alignment, so the gap before the aligned
+    // address is at least new_alignment bytes and has room for a pointer.
+    void *block = ::operator new(bytes + alignment);
+    const auto start = reinterpret_cast<std::uintptr_t>(block);
+    void **aligned =
+        reinterpret_cast<void **>((start + alignment) & ~(alignment - 1));
+    aligned[-1] = block;
+    return aligned;
+  }
+
+  void do_deallocate(void *pointer, size_t bytes, size_t alignment) override {
+    if (alignment <= new_alignment) {
+      ::operator delete(pointer, bytes);
+    } else {
+      ::operator delete(static_cast<void **>(pointer)[-1], bytes + alignment);
+    }
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return dynamic_cast<const HeapResource *>(&other) != nullptr;
+  }
+};
+
+inline std::pmr::memory_resource *heap_resource() {
+  static HeapResource resource;
+  return &resource;
+}
+
+inline std::pmr::memory_resource *&active_memory_resource() {
+  thread_local std::pmr::memory_resource *resource = heap_resource();
+  return resource;
+}
+
+// The resource that dynamic arrays constructed on this thread allocate
+// their elements from. An array keeps the resource it was constructed with
+// for its whole life, so it must not outlive that resource's memory.
+inline std::pmr::memory_resource *current_memory_resource() {
+  return active_memory_resource();
+}
+
+// While alive, dynamic arrays constructed on this thread, including the
+// temporaries of operators and decompositions, allocate from resource.
+class MemoryResourceScope {
+private:
+  std::pmr::memory_resource *previous_;
+
+public:
+  explicit MemoryResourceScope(std::pmr::memory_resource *resource)
+      : previous_(active_memory_resource()) {
+    active_memory_resource() = resource;
+  }
+
+  MemoryResourceScope(const MemoryResourceScope &scope) = delete;
+
+  MemoryResourceScope &operator=(const MemoryResourceScope &scope) = delete;
+
+  ~MemoryResourceScope() { active_memory_resource() = previous_; }
+};
+
+// Dynamic array buffers start on a cache line, which is also the width of
+// an AVX-512 register, so aligned loads can be used from the first element.
+inline constexpr size_t array_alignment = static_cast<size_t>(64);
+
+template <typename T>
+inline constexpr size_t element_alignment = std::max(alignof(T),
+                                                     array_alignment);
+
+template <typename T>
+T *allocate_elements(std::pmr::memory_resource *resource, size_t count) {
+  if (count == static_cast<size_t>(0)) {
+    return nullptr;
+  }
+  T *data = static_cast<T *>(
+      resource->allocate(count * sizeof(T), element_alignment<T>));
+  std::uninitialized_default_construct_n(data, count);
+  return data;
+}
+
+template <typename T>
+void deallocate_elements(std::pmr::memory_resource *resource, T *data,
+                         size_t count) {
+  if (data != nullptr) {
+    std::destroy_n(data, count);
+    resource->deallocate(data, count * sizeof(T), element_alignment<T>);
+  }
+}
+
+// A bump allocator for per-request temporaries. Allocation moves a pointer
+// through blocks taken from the upstream resource, deallocation does
+// nothing, and reset() rewinds to the first block so the next request
+// reuses the same memory without touching the upstream resource. Every
+// array allocated from the arena must be gone before reset().
+class Arena : public std::pmr::memory_resource {
+private:
+  struct Block {
+    std::byte *data;
+    size_t size;
+  };
+
+  static constexpr size_t block_alignment = alignof(std::max_align_t);
+
+  std::pmr::memory_resource *upstream_;
+  std::vector<Block> blocks_;
+  size_t next_block_size_;
+  size_t block_;
+  size_t offset_;
+
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    for (; block_ < blocks_.size(); ++block_, offset_ = 0) {
+      const Block &block = blocks_[block_];
+      // Alignments are powers of two.
+      const auto start = reinterpret_cast<std::uintptr_t>(block.data);
+      const size_t aligned =
+          ((start + offset_ + alignment - 1) & ~(alignment - 1)) - start;
+      if (aligned + bytes <= block.size) {
+        offset_ = aligned + bytes;
+        return block.data + aligned;
+      }
+    }
+    // Blocks double in size, so a request needs few of them once warm.
+    const size_t size = std::max(next_block_size_, bytes + alignment);
+    next_block_size_ = 2 * size;
+    blocks_.push_back(Block{static_cast<std::byte *>(upstream_->allocate(
+                                size, block_alignment)),
+                            size});
+    return do_allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *, size_t, size_t) override {}
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+
+public:
+  explicit Arena(size_t initial_size = static_cast<size_t>(1) << 16,
+                 std::pmr::memory_resource *upstream =
+                     heap_resource())
+      : upstream_(upstream), next_block_size_(initial_size),
+        block_(static_cast<size_t>(0)), offset_(static_cast<size_t>(0)) {}
+
+  Arena(const Arena &arena) = delete;
+
+  Arena &operator=(const Arena &arena) = delete;
+
+  ~Arena() override {
+    for (const Block &block : blocks_) {
+      upstream_->deallocate(block.data, block.size, block_alignment);
+    }
+  }
+
+  // Makes all of the arena's memory available again.
+  void reset() {
+    block_ = static_cast<size_t>(0);
+    offset_ = static_cast<size_t>(0);
+  }
+
+  // Bytes obtained from the upstream resource so far.
+  size_t capacity() const {
+    size_t total = static_cast<size_t>(0);
+    for (const Block &block : blocks_) {
+      total += block.size;
+    }
+    return total;
+  }
+};
+} // namespace sabai
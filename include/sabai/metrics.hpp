@@ -4,11 +4,7 @@
 
 namespace sabai {
 
-template <typename T> double norm(const DynamicVector<T> &vector) {
-  return sqrt(dot(vector, vector));
-}
-
-template <typename T, size_t N> double norm(const StaticVector<T, N> &vector) {
+template <VectorLike Vector> double norm(const Vector &vector) {
   return sqrt(static_cast<double>(dot(vector, vector)));
 }
 } // namespace sabai
\ No newline at end of file
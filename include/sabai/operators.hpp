@@ -2,8 +2,10 @@
 
 #include "sabai/base.hpp"
 #include "sabai/dynamic.hpp"
+#include "sabai/expressions.hpp"
 #include "sabai/static.hpp"
 #include <cmath>
+#include <utility>
 
 namespace sabai {
 
@@ -33,64 +35,6 @@ StaticArray<bool, Shape...> operator!=(const StaticArray<T, Shape...> &left,
   return !(left == right);
 }
 
-template <typename T, size_t... Shape>
-StaticArray<T, Shape...> operator-(const StaticArray<T, Shape...> &array) {
-  auto negative_array = empty_like(array);
-  for (size_t index = 0; index < negative_array.length(); ++index) {
-    negative_array(index) = -array(index);
-  }
-  return negative_array;
-}
-
-template <typename T, size_t... Shape>
-StaticArray<T, Shape...> operator+(const StaticArray<T, Shape...> &left,
-                                   const StaticArray<T, Shape...> &right) {
-  auto summed = empty_like(left);
-  for (size_t index = 0; index < summed.length(); ++index) {
-    summed(index) = left(index) + right(index);
-  }
-  return summed;
-}
-
-template <typename T, size_t... Shape>
-StaticArray<T, Shape...> operator-(const StaticArray<T, Shape...> &left,
-                                   const StaticArray<T, Shape...> &right) {
-  auto summed = empty_like(left);
-  for (size_t index = 0; index < summed.length(); ++index) {
-    summed(index) = left(index) - right(index);
-  }
-  return summed;
-}
-
-template <typename T, size_t... Shape>
-StaticArray<T, Shape...>
-operator/(const T &numerator, const StaticArray<T, Shape...> &denominator) {
-  auto result = empty_like(denominator);
-  for (size_t index = 0; index < denominator.length(); ++index) {
-    result(index) = numerator / denominator(index);
-  }
-  return result;
-}
-
-template <typename T, size_t... Shape>
-StaticArray<T, Shape...> operator/(const StaticArray<T, Shape...> &numerator,
-                                   T divisor) {
-  auto divided = empty_like(numerator);
-  for (size_t index = 0; index < divided.length(); ++index) {
-    divided(index) = numerator(index) / divisor;
-  }
-  return divided;
-}
-
-template <typename T, size_t... Shape>
-StaticArray<T, Shape...> operator/=(StaticArray<T, Shape...> &array,
-                                    T divisor) {
-  for (size_t index = 0; index < array.length(); ++index) {
-    array(index) /= divisor;
-  }
-  return array;
-}
-
 template <typename T, size_t Dim>
 DynamicArray<bool, Dim> operator==(const DynamicArray<T, Dim> &left,
                                    const DynamicArray<T, Dim> &right) {
@@ -116,60 +60,64 @@ DynamicArray<bool, Dim> operator!=(const DynamicArray<T, Dim> &left,
   return !(left == right);
 }
 
-template <typename T, size_t Dim>
-DynamicArray<T, Dim> operator-(const DynamicArray<T, Dim> &array) {
-  auto negative_array = empty_like(array);
-  for (size_t index = 0; index < negative_array.length(); ++index) {
-    negative_array(index) = -array(index);
-  }
-  return negative_array;
+// The arithmetic operators build lazy expressions that are evaluated in a
+// single pass once they are assigned to an array.
+template <typename Array>
+requires ArrayLike<Array>
+constexpr auto operator-(Array &&array) {
+  return UnaryExpression<Negate, Array>(Negate{}, std::forward<Array>(array));
 }
 
-template <typename T, size_t Dim>
-DynamicArray<T, Dim> operator+(const DynamicArray<T, Dim> &left,
-                               const DynamicArray<T, Dim> &right) {
-  auto summed = empty_like(left);
-  for (size_t index = 0; index < summed.length(); ++index) {
-    summed(index) = left(index) + right(index);
-  }
-  return summed;
+template <typename Left, typename Right>
+requires(ArrayLike<Left> &&ArrayLike<Right> &&
+         array_traits<std::remove_cvref_t<Left>>::NumDims ==
+             array_traits<std::remove_cvref_t<Right>>::NumDims) constexpr auto
+operator+(Left &&left, Right &&right) {
+  return BinaryExpression<Add, Left, Right>(Add{}, std::forward<Left>(left),
+                                            std::forward<Right>(right));
 }
 
-template <typename T, size_t Dim>
-DynamicArray<T, Dim> operator-(const DynamicArray<T, Dim> &left,
-                               const DynamicArray<T, Dim> &right) {
-  auto summed = empty_like(left);
-  for (size_t index = 0; index < summed.length(); ++index) {
-    summed(index) = left(index) - right(index);
-  }
-  return summed;
+template <typename Left, typename Right>
+requires(ArrayLike<Left> &&ArrayLike<Right> &&
+         array_traits<std::remove_cvref_t<Left>>::NumDims ==
+             array_traits<std::remove_cvref_t<Right>>::NumDims) constexpr auto
+operator-(Left &&left, Right &&right) {
+  return BinaryExpression<Subtract, Left, Right>(
+      Subtract{}, std::forward<Left>(left), std::forward<Right>(right));
 }
 
-template <typename T, size_t Dim>
-DynamicArray<T, Dim> operator/(const T &numerator,
-                               const DynamicArray<T, Dim> &denominator) {
-  auto result = empty_like(denominator);
-  for (size_t index = 0; index < denominator.length(); ++index) {
-    result(index) = numerator / denominator(index);
-  }
-  return result;
+template <typename Array>
+requires ArrayLike<Array>
+constexpr auto operator/(const ValueTypeOf<Array> &numerator,
+                         Array &&denominator) {
+  using Operation = DivideInto<ValueTypeOf<Array>>;
+  return UnaryExpression<Operation, Array>(
+      Operation{numerator}, std::forward<Array>(denominator));
 }
 
-template <typename T, size_t Dim>
-DynamicArray<T, Dim> operator/(const DynamicArray<T, Dim> &numerator,
-                               T divisor) {
-  auto divided = empty_like(numerator);
-  for (size_t index = 0; index < divided.length(); ++index) {
-    divided(index) = numerator(index) / divisor;
-  }
-  return divided;
+template <typename Array>
+requires ArrayLike<Array>
+constexpr auto operator/(Array &&numerator, const ValueTypeOf<Array> &divisor) {
+  using Operation = DivideBy<ValueTypeOf<Array>>;
+  return UnaryExpression<Operation, Array>(Operation{divisor},
+                                           std::forward<Array>(numerator));
 }
 
-template <typename T, size_t Dim>
-DynamicArray<T, Dim> operator/=(DynamicArray<T, Dim> &array, T divisor) {
-  for (size_t index = 0; index < array.length(); ++index) {
-    array(index) /= divisor;
-  }
+template <ArrayLike Array, ArrayLike Other>
+constexpr Array &operator+=(Array &array, const Other &other) {
+  assign(array, array + other);
+  return array;
+}
+
+template <ArrayLike Array, ArrayLike Other>
+constexpr Array &operator-=(Array &array, const Other &other) {
+  assign(array, array - other);
+  return array;
+}
+
+template <ArrayLike Array>
+constexpr Array &operator/=(Array &array, const ValueTypeOf<Array> &divisor) {
+  assign(array, array / divisor);
   return array;
 }
 
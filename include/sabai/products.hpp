@@ -1,109 +1,53 @@
 #pragma once
 
 #include "sabai/dynamic.hpp"
+#include "sabai/gemm.hpp"
 #include "sabai/operators.hpp"
+#include "sabai/simd.hpp"
 #include "sabai/static.hpp"
 
-namespace sabai {
+#include <utility>
 
-template <typename T>
-DynamicVector<T> operator*(const T &value, const DynamicVector<T> &vector) {
-  DynamicVector<T> answer = empty_like(vector);
-  for (size_t index = static_cast<size_t>(0); index < vector.length();
-       ++index) {
-    answer(index) = value * vector(index);
-  }
-  return answer;
-}
-
-template <typename T, size_t Size>
-StaticVector<T, Size> operator*(const T &value,
-                                const StaticVector<T, Size> &vector) {
-  StaticVector<T, Size> answer;
-  for (size_t index = static_cast<size_t>(0); index < Size; ++index) {
-    answer(index) = value * vector(index);
-  }
-  return answer;
-}
-
-template <typename T, size_t FirstDim, size_t SecondDim, size_t... OtherDims>
-StaticArray<T, FirstDim, SecondDim, OtherDims...>
-operator*(const T &value,
-          const StaticArray<T, FirstDim, SecondDim, OtherDims...> &array) {
-  auto answer = empty_like(array);
-  for (size_t index = static_cast<size_t>(0); index < array.length(); ++index) {
-    answer(index) = value * array(index);
-  }
-  return answer;
-}
-
-template <typename T, size_t NumDims>
-DynamicArray<T, NumDims> operator*(const T &value,
-                                   const DynamicArray<T, NumDims> &array) {
-  auto answer = empty_like(array);
-  for (size_t index = static_cast<size_t>(0); index < array.length(); ++index) {
-    answer(index) = value * array(index);
-  }
-  return answer;
-}
-
-template <typename T>
-DynamicVector<T> operator*(const DynamicVector<T> &vector, const T &value) {
-  DynamicVector<T> answer = empty_like(vector);
-  for (size_t index = static_cast<size_t>(0); index < vector.length();
-       ++index) {
-    answer(index) = vector(index) * value;
-  }
-  return answer;
-}
+namespace sabai {
 
-template <typename T, size_t Size>
-StaticVector<T, Size> operator*(const StaticVector<T, Size> &vector,
-                                const T &value) {
-  StaticVector<T, Size> answer;
-  for (size_t index = static_cast<size_t>(0); index < Size; ++index) {
-    answer(index) = vector(index) * value;
-  }
-  return answer;
+template <typename Array>
+requires ArrayLike<Array>
+constexpr auto operator*(const ValueTypeOf<Array> &value, Array &&array) {
+  using Operation = Scale<ValueTypeOf<Array>>;
+  return UnaryExpression<Operation, Array>(Operation{value},
+                                           std::forward<Array>(array));
 }
 
-template <typename T, size_t FirstDim, size_t SecondDim, size_t... OtherDims>
-StaticArray<T, FirstDim, SecondDim, OtherDims...>
-operator*(const StaticArray<T, FirstDim, SecondDim, OtherDims...> &array,
-          const T &value) {
-  auto answer = empty_like(array);
-  for (size_t index = static_cast<size_t>(0); index < array.length(); ++index) {
-    answer(index) = array(index) * value;
-  }
-  return answer;
+template <typename Array>
+requires ArrayLike<Array>
+constexpr auto operator*(Array &&array, const ValueTypeOf<Array> &value) {
+  using Operation = Scale<ValueTypeOf<Array>>;
+  return UnaryExpression<Operation, Array>(Operation{value},
+                                           std::forward<Array>(array));
 }
 
-template <typename T, size_t NumDims>
-DynamicArray<T, NumDims> operator*(const DynamicArray<T, NumDims> &array,
-                                   const T &value) {
-  auto answer = empty_like(array);
-  for (size_t index = static_cast<size_t>(0); index < array.length(); ++index) {
-    answer(index) = array(index) * value;
-  }
-  return answer;
+template <ArrayLike Array>
+constexpr Array &operator*=(Array &array, const ValueTypeOf<Array> &value) {
+  assign(array, array * value);
+  return array;
 }
 
-template <typename T>
-T dot(const DynamicVector<T> &left, const DynamicVector<T> &right) {
+template <VectorLike Left, VectorLike Right>
+typename array_traits<Left>::ValueType dot(const Left &left,
+                                           const Right &right) {
   if (left.length() != right.length()) {
     throw MismatchedLength(left.length(), right.length());
   }
-  T dot_product = static_cast<T>(0);
-  for (size_t index = static_cast<size_t>(0); index < left.length(); ++index) {
-    dot_product += left(index) * right(index);
+  using T = typename array_traits<Left>::ValueType;
+  if constexpr (is_simd_type<T>::value) {
+    const T *left_data = contiguous_data<const T>(left);
+    const T *right_data = contiguous_data<const T>(right);
+    if (left_data != nullptr && right_data != nullptr) {
+      return simd_dot(left.length(), left_data, right_data);
+    }
   }
-  return dot_product;
-}
-
-template <typename T, size_t M>
-T dot(const StaticVector<T, M> &left, const StaticVector<T, M> &right) {
-  T dot_product = static_cast<T>(0);
-  for (size_t index = static_cast<size_t>(0); index < M; ++index) {
+  auto dot_product = static_cast<T>(0);
+  for (size_t index = static_cast<size_t>(0); index < left.length(); ++index) {
     dot_product += left(index) * right(index);
   }
   return dot_product;
@@ -146,23 +90,87 @@ StaticMatrix<T, M, M> outer(const StaticVector<T, M> &left,
   return result;
 }
 
-template <typename T>
-DynamicMatrix<T> outer(const DynamicVector<T> &left,
-                       const DynamicVector<T> &right) {
+template <VectorLike Left, VectorLike Right>
+DynamicMatrix<typename array_traits<Left>::ValueType>
+outer(const Left &left, const Right &right) {
   const size_t M = left.length();
-  DynamicMatrix<T> result(M, M);
+  const size_t N = right.length();
+  DynamicMatrix<typename array_traits<Left>::ValueType> result(M, N);
   for (size_t row = static_cast<size_t>(0); row < M; ++row) {
-    for (size_t column = static_cast<size_t>(0); column < M; ++column) {
+    for (size_t column = static_cast<size_t>(0); column < N; ++column) {
       result(row, column) = left(row) * right(column);
     }
   }
   return result;
 }
 
+// Dimensions of the static products that are unrolled at compile time and
+// kept in registers instead of going through nested operator() calls.
+constexpr bool is_small_dimension(size_t dimension) {
+  return dimension == static_cast<size_t>(2) ||
+         dimension == static_cast<size_t>(3) ||
+         dimension == static_cast<size_t>(4) ||
+         dimension == static_cast<size_t>(6);
+}
+
+template <typename T, size_t... Dimensions>
+inline constexpr bool has_small_kernel =
+    is_simd_type<T>::value && (is_small_dimension(Dimensions) && ...);
+
+// Columns [Offset, Offset + Width) of one row of a product: the sum over k of
+// left_row[k] times row k of right, a register of Width elements at a time.
+template <size_t Width, size_t Offset, size_t P, typename T, size_t... K>
+void small_product_columns(const T *left_row, const T *right, T *result_row,
+                           std::index_sequence<K...>) {
+  if constexpr (Width == static_cast<size_t>(1)) {
+    result_row[Offset] = ((left_row[K] * right[K * P + Offset]) + ...);
+  } else {
+    using Pack = SimdPack<T, Width * sizeof(T)>;
+    Pack::store(result_row + Offset,
+                ((left_row[K] * Pack::load(right + K * P + Offset)) + ...));
+  }
+}
+
+// Rows of 2, 3, 4 and 6 columns are split into registers of 4, 2 and 1.
+template <size_t N, size_t P, typename T>
+void small_product_row(const T *left_row, const T *right, T *result_row) {
+  constexpr auto k = std::make_index_sequence<N>();
+  if constexpr (P == static_cast<size_t>(4) || P == static_cast<size_t>(6)) {
+    small_product_columns<4, 0, P>(left_row, right, result_row, k);
+  }
+  if constexpr (P == static_cast<size_t>(2) || P == static_cast<size_t>(3)) {
+    small_product_columns<2, 0, P>(left_row, right, result_row, k);
+  }
+  if constexpr (P == static_cast<size_t>(3)) {
+    small_product_columns<1, 2, P>(left_row, right, result_row, k);
+  }
+  if constexpr (P == static_cast<size_t>(6)) {
+    small_product_columns<2, 4, P>(left_row, right, result_row, k);
+  }
+}
+
+template <size_t N, size_t P, typename T, size_t... Rows>
+void small_product(const T *left, const T *right, T *result,
+                   std::index_sequence<Rows...>) {
+  (small_product_row<N, P>(left + Rows * N, right, result + Rows * P), ...);
+}
+
+template <size_t N, typename T, size_t... K>
+T small_row_dot(const T *row, const T *x, std::index_sequence<K...>) {
+  return ((row[K] * x[K]) + ...);
+}
+
 template <typename T, size_t M, size_t N>
 StaticVector<T, M> operator*(const StaticArray<T, M, N> &A,
                              const StaticVector<T, N> &x) {
   StaticVector<T, M> answer;
+  if constexpr (has_small_kernel<T, M, N>) {
+    for (size_t index = static_cast<size_t>(0); index < M; ++index) {
+      answer.data()[index] = small_row_dot<N>(A.data() + index * N, x.data(),
+                                              std::make_index_sequence<N>());
+    }
+    return answer;
+  }
   for (size_t index = static_cast<size_t>(0); index < M; ++index) {
     answer(index) = dot(A(index), x);
   }
@@ -172,38 +180,36 @@ StaticVector<T, M> operator*(const StaticArray<T, M, N> &A,
 template <typename T>
 DynamicVector<T> operator*(const DynamicMatrix<T> &A,
                            const DynamicVector<T> &x) {
-  DynamicVector<T> answer(A.length());
-  for (size_t index = static_cast<size_t>(0); index < answer.length();
-       ++index) {
-    answer(index) = dot(A(index), x);
+  if (A.shape(1) != x.length()) {
+    throw MismatchedLength(A.shape(1), x.length());
   }
+  DynamicVector<T> answer(A.length());
+  gemv(static_cast<T>(1), A.view(), x.view(), static_cast<T>(0),
+       answer.view());
   return answer;
 }
 
 template <typename T>
 DynamicMatrix<T> operator*(const DynamicMatrix<T> &left,
                            const DynamicMatrix<T> &right) {
-  const size_t m = left.length();
-  const size_t n = right.length();
-  if (left(0).length() != n) {
-    throw MismatchedLength(left(0).length(), n);
-  }
-  const size_t p = right(0).length();
-  DynamicMatrix<T> result(m, p);
-  for (size_t row = static_cast<size_t>(0); row < m; ++row) {
-    for (size_t column = static_cast<size_t>(0); column < p; ++column) {
-      result(row, column) = static_cast<T>(0);
-      for (size_t index = static_cast<size_t>(0); index < n; ++index) {
-        result(row, column) += left(row, index) * right(index, column);
-      }
-    }
+  if (left.shape(1) != right.length()) {
+    throw MismatchedLength(left.shape(1), right.length());
   }
+  DynamicMatrix<T> result(left.length(), right.shape(1));
+  gemm(static_cast<T>(1), left.view(), right.view(), static_cast<T>(0),
+       result.view());
   return result;
 }
 
 template <typename T, size_t M, size_t N, size_t P>
 StaticMatrix<T, M, P> operator*(const StaticMatrix<T, M, N> &left,
                                 const StaticMatrix<T, N, P> &right) {
+  if constexpr (has_small_kernel<T, M, N, P>) {
+    StaticMatrix<T, M, P> answer;
+    small_product<N, P>(left.data(), right.data(), answer.data(),
+                        std::make_index_sequence<M>());
+    return answer;
+  }
   auto answer = StaticArray<T, M, P>(static_cast<T>(0));
   for (size_t row = static_cast<size_t>(0); row < M; ++row) {
     for (size_t column = static_cast<size_t>(0); column < P; ++column) {
@@ -1,9 +1,18 @@
 #pragma once
 
+#include "sabai/batch.hpp"
 #include "sabai/decompositions.hpp"
 #include "sabai/dynamic.hpp"
+#include "sabai/expressions.hpp"
+#include "sabai/gemm.hpp"
 #include "sabai/indexing.hpp"
+#include "sabai/inverse.hpp"
+#include "sabai/memory.hpp"
 #include "sabai/metrics.hpp"
 #include "sabai/operators.hpp"
 #include "sabai/products.hpp"
+#include "sabai/simd.hpp"
 #include "sabai/static.hpp"
+#include "sabai/task_graph.hpp"
+#include "sabai/thread_pool.hpp"
+#include "sabai/trsm.hpp"
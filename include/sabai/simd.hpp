@@ -0,0 +1,332 @@
+#pragma once
+
+#include "sabai/base.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SABAI_SIMD_X86 1
+#else
+#define SABAI_SIMD_X86 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SABAI_VECTOR_TYPES 1
+#else
+#define SABAI_VECTOR_TYPES 0
+#endif
+
+namespace sabai {
+
+// Instruction sets the float and double kernels can be compiled for, from
+// weakest to strongest. The level is detected once from CPUID, so a single
+// binary uses the widest registers of whichever host it runs on.
+enum class SimdLevel { Scalar, SSE2, AVX2, AVX512 };
+
+inline SimdLevel detect_simd_level() {
+#if SABAI_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SimdLevel::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return SimdLevel::AVX2;
+  }
+  return SimdLevel::SSE2;
+#else
+  return SimdLevel::Scalar;
+#endif
+}
+
+inline std::atomic<SimdLevel> &active_simd_level() {
+  static std::atomic<SimdLevel> level(detect_simd_level());
+  return level;
+}
+
+inline SimdLevel simd_level() {
+  return active_simd_level().load(std::memory_order_relaxed);
+}
+
+// Caps the kernels at level, which is clamped to what the host supports.
+inline void set_simd_level(SimdLevel level) {
+  active_simd_level().store(std::min(level, detect_simd_level()),
+                            std::memory_order_relaxed);
+}
+
+template <typename T> struct is_simd_type {
+  static constexpr bool value = is_same<T, float>::value ||
+                                is_same<T, double>::value;
+};
+
+// Packs never cross a function boundary by value: loads return references
+// into the array, and results are written through references. How a wide
+// vector is passed depends on the target, so by-value packs would differ in
+// ABI between the kernels built for SSE2, AVX2 and AVX-512.
+#if SABAI_VECTOR_TYPES
+// Bytes wide registers of T. The element-wise operations of these types
+// compile to the instructions of the enclosing function's target.
+template <typename T, size_t Bytes> struct SimdPack {
+  typedef T Type __attribute__((vector_size(Bytes)));
+  // The same register, read from an array of T without alignment or aliasing
+  // requirements.
+  typedef T Unaligned
+      __attribute__((vector_size(Bytes), aligned(alignof(T)), may_alias));
+  static constexpr size_t width = Bytes / sizeof(T);
+
+  static const Unaligned &load(const T *data) {
+    return *reinterpret_cast<const Unaligned *>(data);
+  }
+
+  static void store(T *data, const Type &pack) {
+    *reinterpret_cast<Unaligned *>(data) = pack;
+  }
+
+  static void sqrt(Type &pack) {
+    for (size_t lane = static_cast<size_t>(0); lane < width; ++lane) {
+      pack[lane] = std::sqrt(pack[lane]);
+    }
+  }
+};
+#else
+// Without vector extensions a pack is an array of width elements with the
+// element-wise arithmetic the small product kernels use, which the compiler
+// may still vectorize on its own.
+template <typename T, size_t Bytes> struct SimdPack {
+  static constexpr size_t width = Bytes / sizeof(T);
+
+  struct Type {
+    T lanes[width];
+
+    T &operator[](size_t lane) { return lanes[lane]; }
+    const T &operator[](size_t lane) const { return lanes[lane]; }
+
+    Type &operator+=(const Type &other) {
+      for (size_t lane = static_cast<size_t>(0); lane < width; ++lane) {
+        lanes[lane] += other.lanes[lane];
+      }
+      return *this;
+    }
+
+    friend Type operator+(Type left, const Type &right) {
+      return left += right;
+    }
+
+    friend Type operator*(T left, Type right) {
+      for (size_t lane = static_cast<size_t>(0); lane < width; ++lane) {
+        right.lanes[lane] *= left;
+      }
+      return right;
+    }
+  };
+
+  static Type load(const T *data) {
+    Type pack;
+    std::copy(data, data + width, pack.lanes);
+    return pack;
+  }
+
+  static void store(T *data, const Type &pack) {
+    std::copy(pack.lanes, pack.lanes + width, data);
+  }
+
+  static void sqrt(Type &pack) {
+    for (size_t lane = static_cast<size_t>(0); lane < width; ++lane) {
+      pack[lane] = std::sqrt(pack[lane]);
+    }
+  }
+};
+#endif
+
+// The one-lane counterpart of SimdPack, used for the elements left over
+// after the last full register and for types without SIMD kernels.
+template <typename T> struct ScalarPack {
+  using Type = T;
+  static constexpr size_t width = static_cast<size_t>(1);
+
+  static const T &load(const T *data) { return *data; }
+
+  static void store(T *data, const Type &value) { *data = value; }
+
+  static void sqrt(Type &value) { value = std::sqrt(value); }
+};
+
+#if SABAI_SIMD_X86
+template <size_t Bytes, typename T>
+T dot_kernel(size_t length, const T *left, const T *right) {
+  using Pack = SimdPack<T, Bytes>;
+  constexpr size_t width = Pack::width;
+  typename Pack::Type first = {};
+  typename Pack::Type second = {};
+  size_t index = static_cast<size_t>(0);
+  for (; index + 2 * width <= length; index += 2 * width) {
+    first += Pack::load(left + index) * Pack::load(right + index);
+    second +=
+        Pack::load(left + index + width) * Pack::load(right + index + width);
+  }
+  for (; index + width <= length; index += width) {
+    first += Pack::load(left + index) * Pack::load(right + index);
+  }
+  first += second;
+  T dot_product = static_cast<T>(0);
+  for (size_t lane = static_cast<size_t>(0); lane < width; ++lane) {
+    dot_product += first[lane];
+  }
+  for (; index < length; ++index) {
+    dot_product += left[index] * right[index];
+  }
+  return dot_product;
+}
+
+// Writes evaluator's elements to result, a register at a time. The
+// evaluator provides packet<Pack>(index, pack) and element(index).
+template <size_t Bytes, typename T, typename Evaluator>
+void evaluate_kernel(size_t length, T *result, const Evaluator &evaluator) {
+  using Pack = SimdPack<T, Bytes>;
+  const size_t packed = length - length % Pack::width;
+  for (size_t index = static_cast<size_t>(0); index < packed;
+       index += Pack::width) {
+    typename Pack::Type pack;
+    evaluator.template packet<Pack>(index, pack);
+    Pack::store(result + index, pack);
+  }
+  for (size_t index = packed; index < length; ++index) {
+    result[index] = evaluator.element(index);
+  }
+}
+
+// Calls kernel.template operator()<Pack>(index) for index = 0, width,
+// 2 width, ... with the register-wide Pack, then once per remaining index
+// with ScalarPack. Each call handles the elements [index, index + width) of
+// a structure-of-arrays batch.
+template <size_t Bytes, typename T, typename Kernel>
+void batch_kernel(size_t size, const Kernel &kernel) {
+  using Pack = SimdPack<T, Bytes>;
+  size_t index = static_cast<size_t>(0);
+  for (; index + Pack::width <= size; index += Pack::width) {
+    kernel.template operator()<Pack>(index);
+  }
+  for (; index < size; ++index) {
+    kernel.template operator()<ScalarPack<T>>(index);
+  }
+}
+
+// Each entry point is compiled for its instruction set and flattened, so the
+// kernel and the operations it inlines are generated for that target too.
+template <typename T>
+__attribute__((target("sse2"), flatten)) T
+dot_sse2(size_t length, const T *left, const T *right) {
+  return dot_kernel<16>(length, left, right);
+}
+
+template <typename T, typename Evaluator>
+__attribute__((target("sse2"), flatten)) void
+evaluate_sse2(size_t length, T *result, const Evaluator &evaluator) {
+  evaluate_kernel<16>(length, result, evaluator);
+}
+
+template <typename T, typename Kernel>
+__attribute__((target("sse2"), flatten)) void
+batch_sse2(size_t size, const Kernel &kernel) {
+  batch_kernel<16, T>(size, kernel);
+}
+
+template <typename T>
+__attribute__((target("avx2,fma"), flatten)) T
+dot_avx2(size_t length, const T *left, const T *right) {
+  return dot_kernel<32>(length, left, right);
+}
+
+template <typename T, typename Evaluator>
+__attribute__((target("avx2,fma"), flatten)) void
+evaluate_avx2(size_t length, T *result, const Evaluator &evaluator) {
+  evaluate_kernel<32>(length, result, evaluator);
+}
+
+template <typename T, typename Kernel>
+__attribute__((target("avx2,fma"), flatten)) void
+batch_avx2(size_t size, const Kernel &kernel) {
+  batch_kernel<32, T>(size, kernel);
+}
+
+template <typename T>
+__attribute__((target("avx512f"), flatten)) T
+dot_avx512(size_t length, const T *left, const T *right) {
+  return dot_kernel<64>(length, left, right);
+}
+
+template <typename T, typename Evaluator>
+__attribute__((target("avx512f"), flatten)) void
+evaluate_avx512(size_t length, T *result, const Evaluator &evaluator) {
+  evaluate_kernel<64>(length, result, evaluator);
+}
+
+template <typename T, typename Kernel>
+__attribute__((target("avx512f"), flatten)) void
+batch_avx512(size_t size, const Kernel &kernel) {
+  batch_kernel<64, T>(size, kernel);
+}
+#endif
+
+template <typename T>
+T simd_dot(size_t length, const T *left, const T *right) {
+  switch (simd_level()) {
+#if SABAI_SIMD_X86
+  case SimdLevel::AVX512:
+    return dot_avx512(length, left, right);
+  case SimdLevel::AVX2:
+    return dot_avx2(length, left, right);
+  case SimdLevel::SSE2:
+    return dot_sse2(length, left, right);
+#endif
+  default:
+    T dot_product = static_cast<T>(0);
+    for (size_t index = static_cast<size_t>(0); index < length; ++index) {
+      dot_product += left[index] * right[index];
+    }
+    return dot_product;
+  }
+}
+
+template <typename T, typename Evaluator>
+void simd_evaluate(size_t length, T *result, const Evaluator &evaluator) {
+  switch (simd_level()) {
+#if SABAI_SIMD_X86
+  case SimdLevel::AVX512:
+    return evaluate_avx512(length, result, evaluator);
+  case SimdLevel::AVX2:
+    return evaluate_avx2(length, result, evaluator);
+  case SimdLevel::SSE2:
+    return evaluate_sse2(length, result, evaluator);
+#endif
+  default:
+    for (size_t index = static_cast<size_t>(0); index < length; ++index) {
+      result[index] = evaluator.element(index);
+    }
+  }
+}
+
+// Runs a batch kernel (see batch_kernel) with the widest registers the host
+// supports.
+template <typename T, typename Kernel>
+void simd_batch(size_t size, const Kernel &kernel) {
+  if constexpr (is_simd_type<T>::value) {
+    switch (simd_level()) {
+#if SABAI_SIMD_X86
+    case SimdLevel::AVX512:
+      return batch_avx512<T>(size, kernel);
+    case SimdLevel::AVX2:
+      return batch_avx2<T>(size, kernel);
+    case SimdLevel::SSE2:
+      return batch_sse2<T>(size, kernel);
+#endif
+    default:
+      break;
+    }
+  }
+  for (size_t index = static_cast<size_t>(0); index < size; ++index) {
+    kernel.template operator()<ScalarPack<T>>(index);
+  }
+}
+} // namespace sabai
@@ -1,44 +1,149 @@
 #pragma once
 
-#include "sabai/base.hpp"
+#include "sabai/expressions.hpp"
 
+#include <algorithm>
 #include <initializer_list>
+#include <type_traits>
 
 namespace sabai {
 
 template <typename T, size_t... Shape> class StaticArray;
 
+template <typename T, size_t FirstDim, size_t... OtherDims>
+class StaticArrayView {
+public:
+  using ValueType = std::remove_const_t<T>;
+  static constexpr size_t NumDims =
+      static_cast<size_t>(1) + sizeof...(OtherDims);
+
+protected:
+  T *data_;
+  size_t strides_[NumDims];
+
+  constexpr void check_bounds(size_t index) const {
+    if (index >= FirstDim) {
+      throw OutOfRange(index, FirstDim);
+    }
+  }
+
+  constexpr void check_input(size_t index) const {
+    if constexpr (bounds_checked) {
+      check_bounds(index);
+    }
+  }
+
+public:
+  constexpr StaticArrayView(T *data, const size_t *strides) : data_(data) {
+    for (size_t dim = static_cast<size_t>(0); dim < NumDims; ++dim) {
+      strides_[dim] = strides[dim];
+    }
+  }
+
+  constexpr StaticArrayView(const StaticArrayView &view) = default;
+
+  constexpr decltype(auto) operator()(size_t index) const {
+    check_input(index);
+    if constexpr (NumDims == static_cast<size_t>(1)) {
+      return (data_[index * strides_[0]]);
+    } else {
+      return StaticArrayView<T, OtherDims...>(data_ + index * strides_[0],
+                                              strides_ + 1);
+    }
+  }
+
+  template <typename... OtherIndices>
+  requires(sizeof...(OtherIndices) > 0 &&
+           sizeof...(OtherIndices) < NumDims) constexpr decltype(auto)
+  operator()(size_t index, OtherIndices... others) const {
+    return (*this)(index)(others...);
+  }
+
+  template <typename... OtherIndices>
+  requires(sizeof...(OtherIndices) < NumDims) constexpr decltype(auto)
+      at(size_t index, OtherIndices... others) const {
+    check_bounds(index);
+    if constexpr (sizeof...(OtherIndices) == static_cast<size_t>(0)) {
+      return (*this)(index);
+    } else {
+      return (*this)(index).at(others...);
+    }
+  }
+
+  constexpr size_t length() const { return FirstDim; }
+
+  constexpr size_t stride(size_t dim) const { return strides_[dim]; }
+
+  constexpr T *data() const { return data_; }
+
+  constexpr void fill(ValueType value) const {
+    for (size_t index = static_cast<size_t>(0); index < FirstDim; ++index) {
+      if constexpr (NumDims == static_cast<size_t>(1)) {
+        (*this)(index) = value;
+      } else {
+        (*this)(index).fill(value);
+      }
+    }
+  }
+
+  constexpr void operator=(const StaticArrayView &array) const {
+    sabai::assign(*this, array);
+  }
+
+  template <ArrayLike Array>
+  requires(array_traits<Array>::NumDims == NumDims) constexpr void
+  operator=(const Array &array) const {
+    sabai::assign(*this, array);
+  }
+};
+
 template <typename T, size_t Dim> class StaticArray<T, Dim> {
 protected:
+  template <typename, size_t...> friend class StaticArray;
+
   T data_[Dim];
 
-  void check_input(size_t index) const {
+  // Writes the values of a (possibly nested) initializer list to
+  // destination in row-major order.
+  static constexpr void copy_initializer(std::initializer_list<T> values,
+                                         T *destination) {
+    std::copy(values.begin(), values.end(), destination);
+  }
+
+  constexpr void check_bounds(size_t index) const {
     if (index >= Dim) {
       throw OutOfRange(index, Dim);
     }
   }
 
+  constexpr void check_input(size_t index) const {
+    if constexpr (bounds_checked) {
+      check_bounds(index);
+    }
+  }
+
 public:
   using InitializerList = std::initializer_list<T>;
 
-  constexpr StaticArray(){};
+  constexpr StaticArray() = default;
 
   constexpr StaticArray(T initial_value) { fill(initial_value); }
 
   constexpr StaticArray(InitializerList values) {
-    auto iter = values.begin();
-    for (size_t index = static_cast<size_t>(0); index < values.size();
-         ++index) {
-      data_[index] = *iter;
-      ++iter;
-    }
+    copy_initializer(values, data_);
   }
 
-  constexpr StaticArray(const StaticArray &array) {
-    for (size_t index = static_cast<size_t>(0); index < array.length();
-         ++index) {
-      data_[index] = array(index);
-    }
+  constexpr StaticArray(const StaticArray &array) = default;
+
+  constexpr StaticArray(StaticArray &&array) = default;
+
+  // Evaluates views and elementwise expressions into a new array.
+  template <ArrayLike Array>
+  requires(!is_same<Array, StaticArray>::value &&
+           is_same<typename array_traits<Array>::ArrayType,
+                   StaticArray>::value) constexpr StaticArray(const Array
+                                                                  &array) {
+    sabai::assign(*this, array);
   }
 
   constexpr void fill(T value) {
@@ -57,6 +162,16 @@ public:
     return data_[index];
   }
 
+  constexpr T &at(size_t index) {
+    check_bounds(index);
+    return data_[index];
+  }
+
+  constexpr T at(size_t index) const {
+    check_bounds(index);
+    return data_[index];
+  }
+
   template <size_t Size>
   constexpr StaticArray<T, Size>
   operator()(const StaticArray<size_t, Size> &indices) const {
@@ -67,88 +182,182 @@ public:
     return indexed;
   }
 
-  constexpr void operator=(const StaticArray &array) {
-    for (size_t index = static_cast<size_t>(0); index < array.length();
-         ++index) {
-      data_[index] = array(index);
-    }
+  constexpr StaticArray &operator=(const StaticArray &array) = default;
+
+  constexpr StaticArray &operator=(StaticArray &&array) = default;
+
+  template <ArrayLike Array>
+  requires(!is_same<Array, StaticArray>::value &&
+           is_same<typename array_traits<Array>::ArrayType,
+                   StaticArray>::value) constexpr StaticArray &
+  operator=(const Array &array) {
+    sabai::assign(*this, array);
+    return *this;
   }
 
   constexpr size_t length() const { return Dim; }
+
+  static constexpr size_t size() { return Dim; }
+
+  constexpr T *data() { return data_; }
+
+  constexpr const T *data() const { return data_; }
+};
+
+// Row-major strides of a StaticArray of the given shape, known at compile
+// time, for the views of its rows.
+template <size_t... Shape> struct StaticStrides {
+  size_t values[sizeof...(Shape)];
+
+  constexpr StaticStrides() : values{} {
+    const size_t shape[sizeof...(Shape)] = {Shape...};
+    size_t stride = static_cast<size_t>(1);
+    for (size_t dim = sizeof...(Shape); dim-- > static_cast<size_t>(0);) {
+      values[dim] = stride;
+      stride *= shape[dim];
+    }
+  }
 };
 
+template <size_t... Shape>
+inline constexpr StaticStrides<Shape...> static_strides{};
+
 template <typename T, size_t FirstDim, size_t SecondDim, size_t... OtherDim>
 class StaticArray<T, FirstDim, SecondDim, OtherDim...> {
 protected:
+  template <typename, size_t...> friend class StaticArray;
+
   using SubArray = StaticArray<T, SecondDim, OtherDim...>;
+  using Row = StaticArrayView<T, SecondDim, OtherDim...>;
+  using ConstRow = StaticArrayView<const T, SecondDim, OtherDim...>;
   static constexpr size_t NumDims =
       static_cast<size_t>(2) + sizeof...(OtherDim);
-  SubArray data_[FirstDim];
+  static constexpr size_t row_size = (SecondDim * ... * OtherDim);
+  // One flat block of elements in row-major order. Every copy and move is
+  // defaulted, so the array is trivially copyable and copies with memcpy or
+  // register moves; rows are views into the block.
+  T data_[FirstDim * row_size];
+
+  constexpr void check_bounds(size_t index) const {
+    if (index >= FirstDim) {
+      throw OutOfRange(index, FirstDim);
+    }
+  }
 
   constexpr void check_input(size_t index) const {
-    if (index >= FirstDim || index < 0) {
-      throw OutOfRange(index, FirstDim);
+    if constexpr (bounds_checked) {
+      check_bounds(index);
     }
   }
 
+  template <size_t Rows, size_t Columns>
+  constexpr void check_block(size_t row, size_t column) const {
+    if (row + Rows > FirstDim) {
+      throw OutOfRange(row + Rows - static_cast<size_t>(1), FirstDim);
+    }
+    if (column + Columns > SecondDim) {
+      throw OutOfRange(column + Columns - static_cast<size_t>(1), SecondDim);
+    }
+  }
+
+  static constexpr void copy_initializer(
+      std::initializer_list<typename SubArray::InitializerList> rows,
+      T *destination) {
+    for (const auto &values : rows) {
+      SubArray::copy_initializer(values, destination);
+      destination += row_size;
+    }
+  }
+
+  constexpr Row row(size_t index) {
+    return Row(data_ + index * row_size,
+               static_strides<SecondDim, OtherDim...>.values);
+  }
+
+  constexpr ConstRow row(size_t index) const {
+    return ConstRow(data_ + index * row_size,
+                    static_strides<SecondDim, OtherDim...>.values);
+  }
+
 public:
   using InitializerList =
       std::initializer_list<typename SubArray::InitializerList>;
 
-  constexpr StaticArray(){};
+  constexpr StaticArray() = default;
 
   constexpr StaticArray(T initial_value) { fill(initial_value); }
 
   constexpr StaticArray(InitializerList initializer_list) {
-    size_t i = static_cast<size_t>(0);
-    for (auto iter = initializer_list.begin(); iter != initializer_list.end();
-         ++iter) {
-      data_[i] = SubArray(*iter);
-      ++i;
-    }
+    copy_initializer(initializer_list, data_);
   }
 
-  constexpr StaticArray(const StaticArray &array) {
-    for (size_t index = static_cast<size_t>(0); index < array.length();
-         ++index) {
-      data_[index] = array(index);
-    }
+  constexpr StaticArray(const StaticArray &array) = default;
+
+  constexpr StaticArray(StaticArray &&array) = default;
+
+  // Evaluates views and elementwise expressions into a new array.
+  template <ArrayLike Array>
+  requires(!is_same<Array, StaticArray>::value &&
+           is_same<typename array_traits<Array>::ArrayType,
+                   StaticArray>::value) constexpr StaticArray(const Array
+                                                                  &array) {
+    sabai::assign(*this, array);
   }
 
   constexpr void fill(T value) {
-    for (size_t i = static_cast<size_t>(0); i < FirstDim; ++i) {
-      data_[i].fill(value);
+    for (size_t i = static_cast<size_t>(0); i < size(); ++i) {
+      data_[i] = value;
     }
   }
 
-  constexpr void fill(const StaticArray &array) {
-    for (size_t index = static_cast<size_t>(0); index < FirstDim; ++index) {
-      data_[index].fill(array(index));
-    }
-  }
+  constexpr void fill(const StaticArray &array) { *this = array; }
 
-  constexpr SubArray &operator()(size_t index) {
+  constexpr Row operator()(size_t index) {
     check_input(index);
-    return data_[index];
+    return row(index);
   }
 
-  constexpr SubArray operator()(size_t index) const {
+  constexpr ConstRow operator()(size_t index) const {
     check_input(index);
-    return data_[index];
+    return row(index);
   }
 
   template <typename... OtherIndices>
-  constexpr auto operator()(size_t first, size_t second,
-                            OtherIndices... others) const {
+  constexpr decltype(auto) operator()(size_t first, size_t second,
+                                      OtherIndices... others) const {
     check_input(first);
-    return data_[first](second, others...);
+    return row(first)(second, others...);
   }
 
   template <typename... OtherIndices>
-  constexpr auto &operator()(size_t first, size_t second,
-                             OtherIndices... others) {
+  constexpr decltype(auto) operator()(size_t first, size_t second,
+                                      OtherIndices... others) {
     check_input(first);
-    return data_[first](second, others...);
+    return row(first)(second, others...);
+  }
+
+  constexpr Row at(size_t index) {
+    check_bounds(index);
+    return row(index);
+  }
+
+  constexpr ConstRow at(size_t index) const {
+    check_bounds(index);
+    return row(index);
+  }
+
+  template <typename... OtherIndices>
+  constexpr decltype(auto) at(size_t first, size_t second,
+                              OtherIndices... others) const {
+    check_bounds(first);
+    return row(first).at(second, others...);
+  }
+
+  template <typename... OtherIndices>
+  constexpr decltype(auto) at(size_t first, size_t second,
+                              OtherIndices... others) {
+    check_bounds(first);
+    return row(first).at(second, others...);
   }
 
   template <size_t Size>
@@ -156,19 +365,85 @@ public:
   operator()(const StaticArray<size_t, Size> &indices) const {
     StaticArray<T, Size, SecondDim, OtherDim...> indexed;
     for (size_t index = static_cast<size_t>(0); index < Size; ++index) {
-      indexed(index) = data_[indices(index)];
+      const T *source = data_ + indices(index) * row_size;
+      for (size_t k = static_cast<size_t>(0); k < row_size; ++k) {
+        indexed.data()[index * row_size + k] = source[k];
+      }
     }
     return indexed;
   }
 
-  constexpr void operator=(const StaticArray &array) {
-    for (size_t index = static_cast<size_t>(0); index < array.length();
-         ++index) {
-      data_[index] = array(index);
+  constexpr StaticArray &operator=(const StaticArray &array) = default;
+
+  constexpr StaticArray &operator=(StaticArray &&array) = default;
+
+  template <ArrayLike Array>
+  requires(!is_same<Array, StaticArray>::value &&
+           is_same<typename array_traits<Array>::ArrayType,
+                   StaticArray>::value) constexpr StaticArray &
+  operator=(const Array &array) {
+    sabai::assign(*this, array);
+    return *this;
+  }
+
+  constexpr StaticArrayView<T, FirstDim> column(size_t index)
+      requires(NumDims == static_cast<size_t>(2)) {
+    if (index >= SecondDim) {
+      throw OutOfRange(index, SecondDim);
     }
+    const size_t strides[1] = {SecondDim};
+    return StaticArrayView<T, FirstDim>(data() + index, strides);
+  }
+
+  constexpr StaticArrayView<const T, FirstDim> column(size_t index) const
+      requires(NumDims == static_cast<size_t>(2)) {
+    if (index >= SecondDim) {
+      throw OutOfRange(index, SecondDim);
+    }
+    const size_t strides[1] = {SecondDim};
+    return StaticArrayView<const T, FirstDim>(data() + index, strides);
+  }
+
+  template <size_t Rows, size_t Columns>
+  constexpr StaticArrayView<T, Rows, Columns> block(size_t row, size_t column)
+      requires(NumDims == static_cast<size_t>(2)) {
+    check_block<Rows, Columns>(row, column);
+    const size_t strides[2] = {SecondDim, static_cast<size_t>(1)};
+    return StaticArrayView<T, Rows, Columns>(
+        data() + row * SecondDim + column, strides);
+  }
+
+  template <size_t Rows, size_t Columns>
+  constexpr StaticArrayView<const T, Rows, Columns>
+  block(size_t row, size_t column) const
+      requires(NumDims == static_cast<size_t>(2)) {
+    check_block<Rows, Columns>(row, column);
+    const size_t strides[2] = {SecondDim, static_cast<size_t>(1)};
+    return StaticArrayView<const T, Rows, Columns>(
+        data() + row * SecondDim + column, strides);
   }
 
   constexpr size_t length() const { return FirstDim; }
+
+  static constexpr size_t size() { return FirstDim * row_size; }
+
+  constexpr T *data() { return data_; }
+
+  constexpr const T *data() const { return data_; }
+};
+
+template <typename T, size_t... Shape>
+struct array_traits<StaticArray<T, Shape...>> {
+  using ValueType = T;
+  using ArrayType = StaticArray<T, Shape...>;
+  static constexpr size_t NumDims = sizeof...(Shape);
+};
+
+template <typename T, size_t... Shape>
+struct array_traits<StaticArrayView<T, Shape...>> {
+  using ValueType = std::remove_const_t<T>;
+  using ArrayType = StaticArray<ValueType, Shape...>;
+  static constexpr size_t NumDims = sizeof...(Shape);
 };
 
 template <size_t... Shape> using StaticArrayi = StaticArray<int, Shape...>;
@@ -200,27 +475,10 @@ empty_like(const StaticArray<T, Shape...> &array) {
   return StaticArray<V, Shape...>();
 }
 
-template <typename T, size_t Length>
-constexpr bool all_equal(const StaticVector<T, Length> &left,
-                         const StaticVector<T, Length> &right) {
-  for (size_t index = static_cast<size_t>(0); index < left.length(); ++index) {
-    if (left(index) != right(index)) {
-      return false;
-    }
-  }
-  return true;
-}
-
-template <typename T, size_t Length1, size_t Length2, size_t... Lengths>
-constexpr bool
-all_equal(const StaticArray<T, Length1, Length2, Lengths...> &left,
-          const StaticArray<T, Length1, Length2, Lengths...> &right) {
-  for (size_t index = static_cast<size_t>(0); index < left.length(); ++index) {
-    if (!all_equal(left(index), right(index))) {
-      return false;
-    }
-  }
-  return true;
+template <typename T, size_t... Shape>
+constexpr StaticArray<std::remove_const_t<T>, Shape...>
+empty_like(const StaticArrayView<T, Shape...> &array) {
+  return StaticArray<std::remove_const_t<T>, Shape...>();
 }
 
 template <size_t Length>
@@ -236,8 +494,8 @@ constexpr bool all(const StaticVector<bool, Length> &vector) {
 template <size_t FirstLength, size_t SecondLength, size_t... Shape>
 constexpr bool
 all(const StaticArray<bool, FirstLength, SecondLength, Shape...> &array) {
-  for (size_t index = static_cast<size_t>(0); index < array.length(); ++index) {
-    if (!all(array(index))) {
+  for (size_t index = static_cast<size_t>(0); index < array.size(); ++index) {
+    if (!array.data()[index]) {
       return false;
     }
   }
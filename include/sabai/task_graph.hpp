@@ -0,0 +1,175 @@
+#pragma once
+
+#include "sabai/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace sabai {
+
+// A set of tasks with dependencies between them, run on the thread pool so
+// that each task starts as soon as everything it depends on has finished.
+// Every thread owns a queue of ready tasks. It runs the newest of them first
+// and, when its queue is empty, steals the oldest task of another thread.
+// Threads that find no ready task sleep until one is queued or the graph
+// finishes.
+class TaskGraph {
+public:
+  using TaskId = size_t;
+
+  // Stands for "no task" in a list of dependencies.
+  static constexpr TaskId none = SIZE_MAX;
+
+private:
+  struct Task {
+    std::function<void()> work;
+    std::vector<TaskId> successors;
+    size_t dependencies;
+  };
+
+  struct ReadyQueue {
+    std::mutex mutex;
+    std::deque<TaskId> tasks;
+  };
+
+  std::vector<Task> tasks_;
+
+public:
+  // Adds a task that may run once every task in dependencies has finished.
+  // Dependencies must already be in the graph; none and repeats are
+  // ignored.
+  TaskId add(std::function<void()> work,
+             const std::vector<TaskId> &dependencies) {
+    const TaskId id = tasks_.size();
+    tasks_.push_back(Task{std::move(work), {}, static_cast<size_t>(0)});
+    std::vector<TaskId> unique;
+    for (const TaskId dependency : dependencies) {
+      if (dependency != none &&
+          std::find(unique.begin(), unique.end(), dependency) ==
+              unique.end()) {
+        unique.push_back(dependency);
+        tasks_[dependency].successors.push_back(id);
+        ++tasks_[id].dependencies;
+      }
+    }
+    return id;
+  }
+
+  size_t size() const { return tasks_.size(); }
+
+  // Runs every task once on the given pool. Work done inside a task runs
+  // serially, since the graph already occupies every thread. If a task
+  // throws, no further tasks are started and the first exception is
+  // rethrown.
+  void run(ThreadPool &pool = thread_pool()) {
+    const size_t count = tasks_.size();
+    if (count == static_cast<size_t>(0)) {
+      return;
+    }
+    const size_t participants = std::min(pool.size(), count);
+    std::vector<std::atomic<size_t>> pending(count);
+    std::vector<ReadyQueue> queues(participants);
+    // Tasks queued and not yet taken, counted before a task is pushed and
+    // after it is popped, so it is zero only when every queue is empty.
+    size_t ready = static_cast<size_t>(0);
+    size_t next_queue = static_cast<size_t>(0);
+    for (TaskId id = static_cast<TaskId>(0); id < count; ++id) {
+      pending[id] = tasks_[id].dependencies;
+      if (tasks_[id].dependencies == static_cast<size_t>(0)) {
+        queues[next_queue].tasks.push_back(id);
+        next_queue = (next_queue + static_cast<size_t>(1)) % participants;
+        ++ready;
+      }
+    }
+    std::atomic<size_t> remaining = count;
+    std::atomic<bool> failed = false;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+
+    // Locking wake_mutex before notifying means a thread that has just seen
+    // the old state under it is already waiting, so no wakeup is lost.
+    auto wake_all = [&]() {
+      { std::lock_guard<std::mutex> lock(wake_mutex); }
+      wake.notify_all();
+    };
+
+    auto take = [&](size_t own, TaskId &id) {
+      for (size_t offset = static_cast<size_t>(0); offset < participants;
+           ++offset) {
+        ReadyQueue &queue = queues[(own + offset) % participants];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+          if (offset == static_cast<size_t>(0)) {
+            id = queue.tasks.back();
+            queue.tasks.pop_back();
+          } else {
+            id = queue.tasks.front();
+            queue.tasks.pop_front();
+          }
+          std::lock_guard<std::mutex> wake_lock(wake_mutex);
+          --ready;
+          return true;
+        }
+      }
+      return false;
+    };
+
+    // A nested parallel_for falls back to a single chunk, whose thread then
+    // works through all the queues on its own.
+    pool.parallel_for(
+        participants, static_cast<size_t>(1), [&](size_t own, size_t) {
+          ThreadPool::SerialScope serial;
+          while (remaining > static_cast<size_t>(0) && !failed) {
+            TaskId id;
+            if (!take(own, id)) {
+              std::unique_lock<std::mutex> lock(wake_mutex);
+              wake.wait(lock, [&]() {
+                return ready > static_cast<size_t>(0) ||
+                       remaining == static_cast<size_t>(0) || failed;
+              });
+              continue;
+            }
+            try {
+              tasks_[id].work();
+            } catch (...) {
+              std::lock_guard<std::mutex> lock(error_mutex);
+              if (!error) {
+                error = std::current_exception();
+              }
+              failed = true;
+              wake_all();
+              return;
+            }
+            for (const TaskId successor : tasks_[id].successors) {
+              if (--pending[successor] == static_cast<size_t>(0)) {
+                {
+                  std::lock_guard<std::mutex> lock(wake_mutex);
+                  ++ready;
+                }
+                {
+                  std::lock_guard<std::mutex> lock(queues[own].mutex);
+                  queues[own].tasks.push_back(successor);
+                }
+                wake.notify_one();
+              }
+            }
+            if (--remaining == static_cast<size_t>(0)) {
+              wake_all();
+            }
+          }
+        });
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+};
+} // namespace sabai
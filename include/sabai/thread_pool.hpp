@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sabai {
+
+// A fixed set of worker threads shared by the parallel kernels. The thread
+// that calls parallel_for runs one of the chunks itself, so a pool of size N
+// owns N - 1 workers.
+class ThreadPool {
+private:
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stopping_;
+
+  static bool &is_worker() {
+    thread_local bool worker = false;
+    return worker;
+  }
+
+  void start(size_t num_threads) {
+    stopping_ = false;
+    for (size_t index = static_cast<size_t>(1); index < num_threads;
+         ++index) {
+      workers_.emplace_back([this] { run(); });
+    }
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    condition_.notify_all();
+    for (std::thread &worker : workers_) {
+      worker.join();
+    }
+    workers_.clear();
+  }
+
+  void run() {
+    is_worker() = true;
+    while (true) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+public:
+  // While alive, parallel_for calls made on the constructing thread run
+  // serially, as they do on workers. Used by schedulers that already keep
+  // every thread busy.
+  class SerialScope {
+  private:
+    bool previous_;
+
+  public:
+    SerialScope() : previous_(is_worker()) { is_worker() = true; }
+
+    SerialScope(const SerialScope &scope) = delete;
+
+    SerialScope &operator=(const SerialScope &scope) = delete;
+
+    ~SerialScope() { is_worker() = previous_; }
+  };
+
+  explicit ThreadPool(size_t num_threads) {
+    start(std::max(num_threads, static_cast<size_t>(1)));
+  }
+
+  ThreadPool(const ThreadPool &pool) = delete;
+
+  ThreadPool &operator=(const ThreadPool &pool) = delete;
+
+  ~ThreadPool() { stop(); }
+
+  size_t size() const { return workers_.size() + static_cast<size_t>(1); }
+
+  // Must not be called while a parallel_for is running on this pool.
+  void resize(size_t num_threads) {
+    stop();
+    start(std::max(num_threads, static_cast<size_t>(1)));
+  }
+
+  // Splits [0, count) into at most size() contiguous chunks whose boundaries
+  // are multiples of grain and calls body(begin, end) for each of them. Runs
+  // serially when called from a worker, so nested kernels cannot deadlock.
+  // The first exception thrown by a chunk is rethrown once all have finished.
+  template <typename Body>
+  void parallel_for(size_t count, size_t grain, Body &&body) {
+    grain = std::max(grain, static_cast<size_t>(1));
+    const size_t grains = (count + grain - static_cast<size_t>(1)) / grain;
+    const size_t chunks = std::min(size(), grains);
+    if (chunks <= static_cast<size_t>(1) || is_worker()) {
+      body(static_cast<size_t>(0), count);
+      return;
+    }
+
+    std::latch done(static_cast<std::ptrdiff_t>(chunks - 1));
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto run_chunk = [&](size_t chunk) {
+      const size_t begin = grains * chunk / chunks * grain;
+      const size_t end =
+          std::min(grains * (chunk + static_cast<size_t>(1)) / chunks * grain,
+                   count);
+      try {
+        body(begin, end);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    };
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (size_t chunk = static_cast<size_t>(1); chunk < chunks; ++chunk) {
+        tasks_.emplace_back([&run_chunk, &done, chunk] {
+          run_chunk(chunk);
+          done.count_down();
+        });
+      }
+    }
+    condition_.notify_all();
+    run_chunk(static_cast<size_t>(0));
+    done.wait();
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+};
+
+// The SABAI_NUM_THREADS environment variable, or every hardware thread when
+// it is unset.
+inline size_t default_num_threads() {
+  if (const char *value = std::getenv("SABAI_NUM_THREADS")) {
+    const size_t num_threads = std::strtoul(value, nullptr, 10);
+    if (num_threads > static_cast<size_t>(0)) {
+      return num_threads;
+    }
+  }
+  return std::max(static_cast<size_t>(std::thread::hardware_concurrency()),
+                  static_cast<size_t>(1));
+}
+
+// The pool used by the library's kernels, created on first use.
+inline ThreadPool &thread_pool() {
+  static ThreadPool pool(default_num_threads());
+  return pool;
+}
+
+inline size_t num_threads() { return thread_pool().size(); }
+
+inline void set_num_threads(size_t num_threads) {
+  thread_pool().resize(num_threads);
+}
+} // namespace sabai
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "sabai/base.hpp"
+#include "sabai/dynamic.hpp"
+#include "sabai/gemm.hpp"
+
+#include <algorithm>
+
+namespace sabai {
+
+enum class Triangle { Lower, Upper };
+
+// Rows of the triangular factor solved per diagonal block. The rest of each
+// block column is eliminated from the right-hand sides with a GEMM.
+template <typename T> struct TrsmBlocking {
+  static constexpr size_t block = static_cast<size_t>(64);
+};
+
+// Solves A X = B in place by substitution, for the n x n lower or upper
+// triangular a and the n x columns right-hand sides b. Only the given
+// triangle of a is read, and its diagonal is taken to be one when
+// unit_diagonal is set. Each step updates whole rows of b, so the factor is
+// read once for all right-hand sides.
+template <typename Matrix, typename Rhs>
+void triangular_solve(Triangle triangle, bool unit_diagonal, const Matrix &a,
+                      Rhs &&b, size_t n, size_t columns) {
+  for (size_t step = static_cast<size_t>(0); step < n; ++step) {
+    const size_t row = triangle == Triangle::Lower
+                           ? step
+                           : n - static_cast<size_t>(1) - step;
+    const size_t begin = triangle == Triangle::Lower
+                             ? static_cast<size_t>(0)
+                             : row + static_cast<size_t>(1);
+    const size_t end = triangle == Triangle::Lower ? row : n;
+    for (size_t inner = begin; inner < end; ++inner) {
+      const auto factor = a(row, inner);
+      for (size_t column = static_cast<size_t>(0); column < columns;
+           ++column) {
+        b(row, column) -= factor * b(inner, column);
+      }
+    }
+    if (!unit_diagonal) {
+      const auto diagonal = a(row, row);
+      for (size_t column = static_cast<size_t>(0); column < columns;
+           ++column) {
+        b(row, column) /= diagonal;
+      }
+    }
+  }
+}
+
+// Blocked triangular solve with many right-hand sides: overwrites b with the
+// solution X of A X = B. Diagonal blocks of a are solved by substitution and
+// the blocks below (or above) them are applied to the remaining rows of b
+// with gemm. Transposed factors can be passed as transposed() views with the
+// opposite triangle.
+template <typename T>
+void trsm(Triangle triangle, bool unit_diagonal,
+          const DynamicArrayView<const T, 2> &a,
+          const DynamicArrayView<T, 2> &b) {
+  constexpr size_t block = TrsmBlocking<T>::block;
+  const size_t n = a.shape(0);
+  if (a.shape(1) != n) {
+    throw MismatchedLength(n, a.shape(1));
+  }
+  if (b.shape(0) != n) {
+    throw MismatchedLength(n, b.shape(0));
+  }
+  const size_t columns = b.shape(1);
+  for (size_t step = static_cast<size_t>(0); step < n; step += block) {
+    const size_t kb = std::min(block, n - step);
+    const size_t k = triangle == Triangle::Lower ? step : n - step - kb;
+    const DynamicArrayView<T, 2> solved = b.block(k, 0, kb, columns);
+    triangular_solve(triangle, unit_diagonal, a.block(k, k, kb, kb), solved,
+                     kb, columns);
+    if (triangle == Triangle::Lower) {
+      const size_t end = k + kb;
+      if (end < n) {
+        gemm<T>(static_cast<T>(-1), a.block(end, k, n - end, kb), solved,
+                static_cast<T>(1), b.block(end, 0, n - end, columns));
+      }
+    } else if (k > static_cast<size_t>(0)) {
+      gemm<T>(static_cast<T>(-1), a.block(0, k, k, kb), solved,
+              static_cast<T>(1), b.block(0, 0, k, columns));
+    }
+  }
+}
+} // namespace sabai
@@ -0,0 +1,320 @@
+#include "sabai/decompositions.hpp"
+#include "sabai/dynamic.hpp"
+#include "sabai/memory.hpp"
+#include "sabai/operators.hpp"
+#include "sabai/products.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+namespace {
+// Thread pool workers allocate too, so the count is shared across threads.
+std::atomic<size_t> allocation_count = 0;
+}
+
+void *operator new(size_t size) {
+  ++allocation_count;
+  if (void *pointer = std::malloc(size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+
+void operator delete(void *pointer, size_t) noexcept { std::free(pointer); }
+
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+
+void operator delete[](void *pointer, size_t) noexcept { std::free(pointer); }
+
+class AllocationFixture : public ::testing::Test {
+protected:
+  sabai::DynamicVectord a = {1.0, 2.0, 3.0};
+  sabai::DynamicVectord b = {4.0, 5.0, 6.0};
+  sabai::DynamicVectord c = {7.0, 8.0, 9.0};
+  sabai::DynamicMatrixd A = {{1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}};
+  sabai::DynamicMatrixd B = {{6.0, 5.0, 4.0}, {3.0, 2.0, 1.0}};
+  // Longer than the small buffer, so these live on the heap.
+  sabai::DynamicVectord long_a = sabai::DynamicVectord(32);
+  sabai::DynamicVectord long_b = sabai::DynamicVectord(32);
+  size_t start = 0;
+
+  void SetUp() override { start = allocation_count; }
+
+  size_t allocations() const { return allocation_count - start; }
+};
+
+TEST_F(AllocationFixture, VectorSum) {
+  // Short vectors live in the small buffer.
+  sabai::DynamicVectord result = a + b;
+  ASSERT_EQ(allocations(), 0);
+}
+
+TEST_F(AllocationFixture, LongVectorSum) {
+  sabai::DynamicVectord result = long_a + long_b;
+  ASSERT_EQ(allocations(), 1);
+}
+
+TEST_F(AllocationFixture, VectorChain) {
+  sabai::DynamicVectord result = a + b - c / 2.0;
+  ASSERT_EQ(allocations(), 0);
+  ASSERT_EQ(result(2), 4.5);
+}
+
+TEST_F(AllocationFixture, MatrixSum) {
+  sabai::DynamicMatrixd result = A + B;
+  ASSERT_EQ(allocations(), 1);
+}
+
+TEST_F(AllocationFixture, MatrixScaledDifference) {
+  sabai::DynamicMatrixd result = 2.0 * A - B;
+  ASSERT_EQ(allocations(), 1);
+  ASSERT_EQ(result(1, 2), 11.0);
+}
+
+TEST_F(AllocationFixture, MatrixVectorProduct) {
+  sabai::DynamicVectord result = B * a;
+  ASSERT_EQ(allocations(), 0);
+}
+
+TEST_F(AllocationFixture, MoveConstruct) {
+  sabai::DynamicMatrixd moved = std::move(A);
+  ASSERT_EQ(allocations(), 0);
+  ASSERT_EQ(A.length(), 0);
+  ASSERT_EQ(moved(1, 2), 6.0);
+}
+
+TEST_F(AllocationFixture, AssignExpressionReusesBuffer) {
+  const double *buffer = a.data();
+  a = b + c;
+  ASSERT_EQ(allocations(), 0);
+  ASSERT_EQ(a.data(), buffer);
+  ASSERT_EQ(a(0), 11.0);
+}
+
+TEST_F(AllocationFixture, CompoundAssignment) {
+  A -= 2.0 * B;
+  a /= 2.0;
+  ASSERT_EQ(allocations(), 0);
+  ASSERT_EQ(A(0, 0), -11.0);
+  ASSERT_EQ(a(2), 1.5);
+}
+
+TEST_F(AllocationFixture, CopyAssignReusesBuffer) {
+  const double *buffer = A.data();
+  A = B;
+  ASSERT_EQ(allocations(), 0);
+  ASSERT_EQ(A.data(), buffer);
+  ASSERT_TRUE(sabai::all_equal(A, B));
+}
+
+TEST_F(AllocationFixture, CopyAssignResizes) {
+  sabai::DynamicVectord d = {1.0};
+  const size_t before = allocations();
+  d = long_a;
+  ASSERT_EQ(allocations() - before, 1);
+  ASSERT_TRUE(sabai::all_equal(d, long_a));
+}
+
+TEST_F(AllocationFixture, Swap) {
+  const double *buffer_a = long_a.data();
+  const double *buffer_b = long_b.data();
+  sabai::swap(long_a, long_b);
+  ASSERT_EQ(allocations(), 0);
+  ASSERT_EQ(long_a.data(), buffer_b);
+  ASSERT_EQ(long_b.data(), buffer_a);
+}
+
+TEST_F(AllocationFixture, SwapCopiesSmallBuffers) {
+  const double *buffer_a = a.data();
+  long_b(0) = 10.0;
+  sabai::swap(a, b);
+  sabai::swap(c, long_b);
+  ASSERT_EQ(allocations(), 0);
+  ASSERT_EQ(a.data(), buffer_a);
+  ASSERT_EQ(a(0), 4.0);
+  ASSERT_EQ(b(2), 3.0);
+  ASSERT_EQ(c.length(), 32);
+  ASSERT_EQ(c(0), 10.0);
+  ASSERT_EQ(long_b.length(), 3);
+  ASSERT_EQ(long_b(1), 8.0);
+}
+
+TEST_F(AllocationFixture, StaticDecompositions) {
+  const sabai::StaticArrayd<4, 4> S = {{4.0, 1.0, 0.0, 1.0},
+                                       {1.0, 5.0, 2.0, 0.0},
+                                       {0.0, 2.0, 6.0, 1.0},
+                                       {1.0, 0.0, 1.0, 3.0}};
+  const sabai::StaticVectord<4> y = {1.0, 2.0, 3.0, 4.0};
+  const sabai::QRDecomposition qr(S);
+  const sabai::LUDecomposition lu(S);
+  const sabai::CholeskyDecomposition cholesky(S);
+  const auto x_qr = sabai::solve(qr, y);
+  const auto x_lu = sabai::solve(lu, y);
+  const auto x_cholesky = sabai::solve(cholesky, y);
+  const auto Q = qr.Q();
+  ASSERT_EQ(allocations(), 0);
+  for (size_t i = static_cast<size_t>(0); i < 4; ++i) {
+    ASSERT_NEAR(x_qr(i), x_lu(i), 1e-12);
+    ASSERT_NEAR(x_cholesky(i), x_lu(i), 1e-12);
+  }
+  ASSERT_NEAR(sabai::dot(Q(0), Q(0)), 1.0, 1e-12);
+}
+
+TEST_F(AllocationFixture, SolveIntoAndInplace) {
+  const sabai::DynamicMatrixd S = {{4.0, 1.0, 0.0, 1.0},
+                                   {1.0, 5.0, 2.0, 0.0},
+                                   {0.0, 2.0, 6.0, 1.0},
+                                   {1.0, 0.0, 1.0, 3.0}};
+  const sabai::DynamicVectord y = {1.0, 2.0, 3.0, 4.0};
+  const sabai::DynamicLUDecomposition lu(S);
+  const sabai::DynamicCholeskyDecomposition cholesky(S);
+  const sabai::DynamicQRDecomposition qr(S);
+  const sabai::DynamicVectord expected = sabai::solve(lu, y);
+  sabai::DynamicVectord x_lu(4);
+  sabai::DynamicVectord x_cholesky(4);
+  sabai::DynamicVectord x_qr(4);
+  sabai::DynamicVectord inplace_lu(y);
+  sabai::DynamicVectord inplace_cholesky(y);
+  sabai::DynamicVectord inplace_qr(y);
+
+  const size_t before = allocations();
+  sabai::solve_into(lu, y, x_lu);
+  sabai::solve_into(cholesky, y, x_cholesky);
+  sabai::solve_into(qr, y, x_qr);
+  sabai::solve_inplace(lu, inplace_lu);
+  sabai::solve_inplace(cholesky, inplace_cholesky);
+  sabai::solve_inplace(qr, inplace_qr);
+  ASSERT_EQ(allocations() - before, 0);
+
+  for (size_t i = static_cast<size_t>(0); i < 4; ++i) {
+    ASSERT_NEAR(x_lu(i), expected(i), 1e-12);
+    ASSERT_NEAR(x_cholesky(i), expected(i), 1e-12);
+    ASSERT_NEAR(x_qr(i), expected(i), 1e-12);
+    ASSERT_NEAR(inplace_lu(i), expected(i), 1e-12);
+    ASSERT_NEAR(inplace_cholesky(i), expected(i), 1e-12);
+    ASSERT_NEAR(inplace_qr(i), expected(i), 1e-12);
+  }
+}
+
+TEST_F(AllocationFixture, LeastSquaresSolveIntoWorkspace) {
+  const sabai::DynamicMatrixd A = {
+      {1.0, 2.0}, {3.0, 4.0}, {5.0, 6.0}, {7.0, 9.0}, {1.0, 0.0}};
+  const sabai::DynamicVectord b = {1.0, 2.0, 3.0, 4.0, 5.0};
+  const sabai::DynamicQRDecomposition qr(A);
+  const sabai::DynamicVectord expected = sabai::solve(qr, b);
+  sabai::DynamicVectord x(2);
+  sabai::DynamicVectord workspace(b.length());
+
+  const size_t before = allocations();
+  sabai::solve_into(qr, b, x, workspace.view());
+  ASSERT_EQ(allocations() - before, 0);
+
+  for (size_t i = static_cast<size_t>(0); i < 2; ++i) {
+    ASSERT_NEAR(x(i), expected(i), 1e-12);
+  }
+}
+
+TEST_F(AllocationFixture, LeastSquaresSolveIntoTemporaryWorkspace) {
+  // Taller than the small buffer, so the temporary workspace is allocated.
+  const size_t m = sabai::DynamicVectord::inline_capacity + 1;
+  sabai::DynamicMatrixd A(m, 2);
+  sabai::DynamicVectord b(m);
+  for (size_t i = static_cast<size_t>(0); i < m; ++i) {
+    A(i, 0) = 1.0;
+    A(i, 1) = static_cast<double>(i);
+    b(i) = 2.0 + 3.0 * static_cast<double>(i);
+  }
+  const sabai::DynamicQRDecomposition qr(A);
+  sabai::DynamicVectord x(2);
+
+  const size_t before = allocations();
+  sabai::solve_into(qr, b, x);
+  ASSERT_EQ(allocations() - before, 1);
+
+  ASSERT_NEAR(x(0), 2.0, 1e-10);
+  ASSERT_NEAR(x(1), 3.0, 1e-10);
+}
+
+TEST_F(AllocationFixture, PackedFactorizationsReuseInput) {
+  sabai::DynamicMatrixd S = {{4.0, 1.0, 0.0}, {1.0, 5.0, 2.0}, {0.0, 2.0, 6.0}};
+  sabai::DynamicMatrixd T = S;
+  sabai::DynamicVectord y = {1.0, 2.0, 3.0};
+  sabai::DynamicVectord x = y;
+  const double *lu_buffer = S.data();
+  const double *cholesky_buffer = T.data();
+
+  const size_t before = allocations();
+  const sabai::DynamicPackedLUDecomposition lu(std::move(S));
+  // The pivots fit in the small buffer.
+  ASSERT_EQ(allocations() - before, 0);
+  const sabai::DynamicPackedCholeskyDecomposition cholesky(std::move(T));
+  ASSERT_EQ(allocations() - before, 0);
+  ASSERT_EQ(lu.factors.data(), lu_buffer);
+  ASSERT_EQ(cholesky.factors.data(), cholesky_buffer);
+
+  sabai::solve_inplace(lu, x);
+  sabai::solve_inplace(cholesky, y);
+  ASSERT_EQ(allocations() - before, 0);
+  for (size_t i = static_cast<size_t>(0); i < 3; ++i) {
+    ASSERT_NEAR(x(i), y(i), 1e-12);
+  }
+}
+
+TEST_F(AllocationFixture, ArenaServesTemporaries) {
+  const sabai::DynamicMatrixd S = {
+      {4.0, 1.0, 0.0}, {1.0, 5.0, 2.0}, {0.0, 2.0, 6.0}};
+  const sabai::DynamicVectord y = {1.0, 2.0, 3.0};
+  sabai::Arena arena(static_cast<size_t>(256));
+  auto request = [&]() {
+    const sabai::MemoryResourceScope scope(&arena);
+    const sabai::DynamicLUDecomposition lu(S);
+    const sabai::DynamicCholeskyDecomposition cholesky(S);
+    const sabai::DynamicVectord x = sabai::solve(lu, y);
+    const sabai::DynamicVectord z = sabai::solve(cholesky, y);
+    const sabai::DynamicVectord difference = 2.0 * x - z;
+    return difference(1);
+  };
+  const double expected = request();
+  arena.reset();
+
+  const size_t before = allocations();
+  const size_t capacity = arena.capacity();
+  ASSERT_EQ(request(), expected);
+  ASSERT_EQ(allocations() - before, 0);
+  ASSERT_EQ(arena.capacity(), capacity);
+}
+
+TEST_F(AllocationFixture, RefactorWithWorkspace) {
+  sabai::DynamicMatrixd S(80, 80);
+  for (size_t i = static_cast<size_t>(0); i < 80; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < 80; ++j) {
+      S(i, j) = i == j ? 100.0 : 1.0 / static_cast<double>(1 + i + j);
+    }
+  }
+  sabai::DynamicLUDecomposition<double> lu;
+  sabai::DynamicCholeskyDecomposition<double> cholesky;
+  sabai::DynamicQRDecomposition<double> qr;
+  sabai::DynamicVectord workspace(
+      sabai::DynamicQRDecomposition<double>::workspace_size(80, 80));
+  lu.factor(S, workspace.view());
+  cholesky.factor(S, workspace.view());
+  qr.factor(S, workspace.view());
+
+  const size_t before = allocations();
+  for (size_t cycle = static_cast<size_t>(0); cycle < 3; ++cycle) {
+    S(0, 0) += 1.0;
+    lu.factor(S, workspace.view());
+    cholesky.factor(S, workspace.view());
+    qr.factor(S, workspace.view());
+  }
+  ASSERT_EQ(allocations() - before, 0);
+  ASSERT_NEAR(lu.L(1, 0) * lu.U(0, 0), S(1, 0), 1e-12);
+}
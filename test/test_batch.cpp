@@ -0,0 +1,167 @@
+#include "sabai/batch.hpp"
+#include "sabai/decompositions.hpp"
+#include "sabai/metrics.hpp"
+#include "sabai/products.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+std::vector<sabai::SimdLevel> batch_levels() {
+  std::vector<sabai::SimdLevel> levels;
+  for (auto level : {sabai::SimdLevel::Scalar, sabai::SimdLevel::SSE2,
+                     sabai::SimdLevel::AVX2, sabai::SimdLevel::AVX512}) {
+    if (level <= sabai::detect_simd_level()) {
+      levels.push_back(level);
+    }
+  }
+  return levels;
+}
+
+std::string batch_level_name(
+    const ::testing::TestParamInfo<sabai::SimdLevel> &info) {
+  switch (info.param) {
+  case sabai::SimdLevel::SSE2:
+    return "SSE2";
+  case sabai::SimdLevel::AVX2:
+    return "AVX2";
+  case sabai::SimdLevel::AVX512:
+    return "AVX512";
+  default:
+    return "Scalar";
+  }
+}
+
+// The batched kernels may contract to FMAs, so results match the one at a
+// time versions to rounding only.
+template <typename T, size_t... Shape>
+bool all_close(const sabai::StaticArray<T, Shape...> &left,
+               const sabai::StaticArray<T, Shape...> &right) {
+  for (size_t c = 0; c < (Shape * ...); ++c) {
+    if (std::abs(left.data()[c] - right.data()[c]) > 1e-12) {
+      return false;
+    }
+  }
+  return true;
+}
+
+double value(size_t element, size_t component) {
+  return static_cast<double>((element * 37 + component * 11) % 19) / 4.0 -
+         2.0;
+}
+} // namespace
+
+class BatchFixture : public ::testing::TestWithParam<sabai::SimdLevel> {
+protected:
+  // Not a multiple of any register width, so every kernel has a tail.
+  static constexpr size_t size = 37;
+  sabai::Batch<sabai::StaticMatrixd<3, 3>> A{size};
+  sabai::Batch<sabai::StaticMatrixd<3, 2>> B{size};
+  sabai::Batch<sabai::StaticVectord<3>> x{size};
+  sabai::Batch<sabai::StaticVectord<3>> y{size};
+
+  void SetUp() override {
+    sabai::set_simd_level(GetParam());
+    for (size_t element = 0; element < size; ++element) {
+      for (size_t i = 0; i < 3; ++i) {
+        x(i)(element) = value(element, i);
+        y(i)(element) = value(element, i + 5);
+        for (size_t j = 0; j < 3; ++j) {
+          A(i, j)(element) = value(element, 3 * i + j + 1);
+        }
+        for (size_t j = 0; j < 2; ++j) {
+          B(i, j)(element) = value(element, 2 * i + j + 7);
+        }
+      }
+    }
+  }
+
+  void TearDown() override {
+    sabai::set_simd_level(sabai::detect_simd_level());
+  }
+};
+
+TEST_P(BatchFixture, GetAndSet) {
+  sabai::StaticMatrixd<3, 3> element = A.get(4);
+  ASSERT_EQ(element(1, 2), A(1, 2)(4));
+  element(1, 2) = 9.0;
+  A.set(4, element);
+  ASSERT_EQ(A(1, 2)(4), 9.0);
+  ASSERT_THROW(A.get(size), sabai::OutOfRange);
+}
+
+TEST_P(BatchFixture, Products) {
+  const sabai::Batch<sabai::StaticMatrixd<3, 2>> AB = A * B;
+  const sabai::Batch<sabai::StaticVectord<3>> Ax = A * x;
+  const sabai::Batch<sabai::StaticVectord<3>> crossed = sabai::cross(x, y);
+  const sabai::DynamicVectord dots = sabai::dot(x, y);
+  const sabai::DynamicVectord norms = sabai::norm(x);
+  for (size_t element = 0; element < size; ++element) {
+    const sabai::StaticMatrixd<3, 3> a = A.get(element);
+    const sabai::StaticVectord<3> u = x.get(element);
+    const sabai::StaticVectord<3> v = y.get(element);
+    ASSERT_TRUE(all_close(AB.get(element), a * B.get(element)));
+    ASSERT_TRUE(all_close(Ax.get(element), a * u));
+    ASSERT_TRUE(all_close(crossed.get(element), sabai::cross(u, v)));
+    ASSERT_NEAR(dots(element), sabai::dot(u, v), 1e-12);
+    ASSERT_NEAR(norms(element), sabai::norm(u), 1e-12);
+  }
+}
+
+TEST_P(BatchFixture, MismatchedSizes) {
+  const sabai::Batch<sabai::StaticVectord<3>> shorter(size - 1);
+  ASSERT_THROW(sabai::dot(x, shorter), sabai::MismatchedLength);
+  ASSERT_THROW(A * shorter, sabai::MismatchedLength);
+}
+
+TEST_P(BatchFixture, LUDecomposition) {
+  const sabai::BatchLUDecomposition lu(A);
+  const sabai::Batch<sabai::StaticVectord<3>> solution = sabai::solve(lu, x);
+  for (size_t element = 0; element < size; ++element) {
+    const sabai::LUDecomposition expected(A.get(element));
+    const sabai::StaticMatrixd<3, 3> factors = lu.factors.get(element);
+    for (size_t i = 0; i < 3; ++i) {
+      ASSERT_EQ(lu.P(i)(element), expected.P(i));
+      for (size_t j = 0; j < 3; ++j) {
+        ASSERT_NEAR(factors(i, j), j < i ? expected.L(i, j) : expected.U(i, j),
+                    1e-12);
+      }
+    }
+    ASSERT_TRUE(all_close(solution.get(element),
+                                 sabai::solve(expected, x.get(element))));
+  }
+}
+
+TEST_P(BatchFixture, CholeskyDecomposition) {
+  // A^T A + I is symmetric positive definite.
+  sabai::Batch<sabai::StaticMatrixd<3, 3>> spd(size);
+  for (size_t element = 0; element < size; ++element) {
+    const sabai::StaticMatrixd<3, 3> a = A.get(element);
+    sabai::StaticMatrixd<3, 3> s = sabai::Identity<double, 3>();
+    for (size_t i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < 3; ++j) {
+        for (size_t k = 0; k < 3; ++k) {
+          s(i, j) += a(k, i) * a(k, j);
+        }
+      }
+    }
+    spd.set(element, s);
+  }
+  const sabai::BatchCholeskyDecomposition cholesky(spd);
+  const sabai::Batch<sabai::StaticVectord<3>> solution =
+      sabai::solve(cholesky, x);
+  for (size_t element = 0; element < size; ++element) {
+    const sabai::CholeskyDecomposition expected(spd.get(element));
+    ASSERT_TRUE(all_close(cholesky.cholesky.get(element),
+                                 expected.cholesky));
+    ASSERT_TRUE(all_close(solution.get(element),
+                                 sabai::solve(expected, x.get(element))));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Levels, BatchFixture,
+                         ::testing::ValuesIn(batch_levels()),
+                         batch_level_name);
@@ -3,7 +3,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
+#include <vector>
 
 TEST(DynamicForwardSubstitution, Test1) {
   const sabai::DynamicMatrixd A = {{1.0, 0.0}, {2.0, 1.0}};
@@ -60,6 +63,30 @@ TEST(Cholesky, Test1) {
   ASSERT_TRUE(sabai::all_equal(x_correct, sabai::solve(cholesky, b)));
 }
 
+TEST(Cholesky, Full) {
+  const sabai::StaticArrayd<3, 3> A = {
+      {4.0, 2.0, 2.0}, {2.0, 5.0, 3.0}, {2.0, 3.0, 6.0}};
+  const sabai::StaticVectord<3> b = {2.0, 1.0, 3.0};
+  const sabai::CholeskyDecomposition cholesky(A);
+  const sabai::StaticArrayd<3, 3> &U = cholesky.cholesky;
+  for (size_t i = static_cast<size_t>(0); i < 3; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < 3; ++j) {
+      double value = 0.0;
+      for (size_t k = static_cast<size_t>(0); k < 3; ++k) {
+        value += U(k, i) * U(k, j);
+      }
+      ASSERT_NEAR(value, A(i, j), 1e-12);
+      if (j < i) {
+        ASSERT_EQ(U(i, j), 0.0);
+      }
+    }
+  }
+  const auto Ax = A * sabai::solve(cholesky, b);
+  for (size_t i = static_cast<size_t>(0); i < 3; ++i) {
+    ASSERT_NEAR(Ax(i), b(i), 1e-12);
+  }
+}
+
 TEST(DynamicLUDecomposition, Test1) {
   const sabai::DynamicMatrixd A = {
       {1.0, 1.0, 1.0}, {1.0, 4.0, 2.0}, {4.0, 7.0, 8.0}};
@@ -71,6 +98,93 @@ TEST(DynamicLUDecomposition, Test1) {
   ASSERT_TRUE(sabai::all_equal(A * solution, b));
 }
 
+sabai::DynamicMatrixd lu_test_matrix(size_t rows, size_t columns) {
+  sabai::DynamicMatrixd A(rows, columns);
+  for (size_t i = static_cast<size_t>(0); i < rows; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < columns; ++j) {
+      A(i, j) = static_cast<double>((i * 7919 + j * 104729 + i * j * 31) %
+                                    1000) /
+                    500.0 -
+                1.0;
+    }
+  }
+  return A;
+}
+
+double max_difference(const sabai::DynamicMatrixd &left,
+                      const sabai::DynamicMatrixd &right) {
+  double difference = 0.0;
+  for (size_t i = static_cast<size_t>(0); i < left.length(); ++i) {
+    for (size_t j = static_cast<size_t>(0); j < left.shape(1); ++j) {
+      difference = std::max(difference, std::abs(left(i, j) - right(i, j)));
+    }
+  }
+  return difference;
+}
+
+sabai::DynamicMatrixd spd_test_matrix(size_t n) {
+  const sabai::DynamicMatrixd M = lu_test_matrix(n, n);
+  const sabai::DynamicMatrixd Mt(M.view().transposed());
+  sabai::DynamicMatrixd A = Mt * M;
+  for (size_t i = static_cast<size_t>(0); i < n; ++i) {
+    A(i, i) += static_cast<double>(n);
+  }
+  return A;
+}
+
+TEST(DynamicLUDecomposition, Blocked) {
+  // Spans several panels, with a partial one at the end.
+  const sabai::DynamicMatrixd A = lu_test_matrix(150, 150);
+  const sabai::DynamicLUDecomposition lu(A);
+  const sabai::DynamicMatrixd LU = lu.L * lu.U;
+  ASSERT_LT(max_difference(A(lu.P), LU), 1e-10);
+  for (size_t i = static_cast<size_t>(0); i < A.length(); ++i) {
+    for (size_t j = static_cast<size_t>(0); j < A.length(); ++j) {
+      ASSERT_LE(std::abs(lu.L(i, j)), 1.0);
+      if (j < i) {
+        ASSERT_EQ(lu.U(i, j), 0.0);
+      }
+    }
+  }
+
+  sabai::DynamicVectord b(A.length());
+  for (size_t i = static_cast<size_t>(0); i < b.length(); ++i) {
+    b(i) = static_cast<double>(i % 7) - 3.0;
+  }
+  const sabai::DynamicVectord residual = A * sabai::solve(lu, b) - b;
+  for (size_t i = static_cast<size_t>(0); i < residual.length(); ++i) {
+    ASSERT_LT(std::abs(residual(i)), 1e-8);
+  }
+}
+
+TEST(DynamicLUDecomposition, SolveInplace) {
+  // Pivots on most steps, so the row swaps must replay the permutation.
+  const sabai::DynamicMatrixd A = lu_test_matrix(150, 150);
+  const sabai::DynamicLUDecomposition lu(A);
+  sabai::DynamicVectord b(A.length());
+  for (size_t i = static_cast<size_t>(0); i < b.length(); ++i) {
+    b(i) = static_cast<double>(i % 7) - 3.0;
+  }
+  const sabai::DynamicVectord expected = sabai::solve(lu, b);
+  sabai::DynamicVectord x(b);
+  sabai::solve_inplace(lu, x);
+  for (size_t i = static_cast<size_t>(0); i < x.length(); ++i) {
+    ASSERT_NEAR(x(i), expected(i), 1e-12);
+  }
+  sabai::DynamicVectord short_x(3);
+  ASSERT_THROW(sabai::solve_into(lu, b, short_x), sabai::MismatchedLength);
+}
+
+TEST(DynamicLUDecomposition, Rectangular) {
+  const sabai::DynamicMatrixd tall = lu_test_matrix(150, 90);
+  const sabai::DynamicLUDecomposition tall_lu(tall);
+  ASSERT_LT(max_difference(tall(tall_lu.P), tall_lu.L * tall_lu.U), 1e-10);
+
+  const sabai::DynamicMatrixd wide = lu_test_matrix(90, 150);
+  const sabai::DynamicLUDecomposition wide_lu(wide);
+  ASSERT_LT(max_difference(wide(wide_lu.P), wide_lu.L * wide_lu.U), 1e-10);
+}
+
 TEST(LUDecomposition, Test1) {
   sabai::StaticArrayd<3, 3> A = {
       {1.0, 1.0, 1.0}, {1.0, 4.0, 2.0}, {4.0, 7.0, 8.0}};
@@ -86,13 +200,320 @@ TEST(LUDecomposition, Test1) {
 TEST(QRDecomposition, Static) {
   auto A = sabai::Identity<double, 3>();
   sabai::QRDecomposition qr(A);
-  ASSERT_TRUE(sabai::all_equal(qr.Q * qr.R, A));
+  ASSERT_TRUE(sabai::all_equal(qr.Q() * qr.R(), A));
 }
 
 TEST(QRDecomposition, Dynamic) {
   auto A = sabai::Identity<double>(3);
   sabai::DynamicQRDecomposition qr(A);
-  ASSERT_TRUE(sabai::all_equal(qr.Q * qr.R, A));
+  ASSERT_TRUE(sabai::all_equal(qr.Q() * qr.R(), A));
+}
+
+TEST(DynamicCholesky, Blocked) {
+  // Several panels, factored on one thread and then split across three.
+  const sabai::DynamicMatrixd A = spd_test_matrix(200);
+  const size_t threads = sabai::num_threads();
+  sabai::set_num_threads(1);
+  const sabai::DynamicCholeskyDecomposition serial(A);
+  sabai::set_num_threads(3);
+  const sabai::DynamicCholeskyDecomposition parallel(A);
+  sabai::set_num_threads(threads);
+
+  const sabai::DynamicMatrixd &U = parallel.cholesky;
+  const sabai::DynamicMatrixd Ut(U.view().transposed());
+  ASSERT_LT(max_difference(Ut * U, A), 1e-9);
+  ASSERT_LT(max_difference(serial.cholesky, U), 1e-12);
+  for (size_t i = static_cast<size_t>(0); i < U.length(); ++i) {
+    for (size_t j = static_cast<size_t>(0); j < i; ++j) {
+      ASSERT_EQ(U(i, j), 0.0);
+    }
+  }
+}
+
+TEST(DynamicCholesky, Tiled) {
+  const sabai::DynamicMatrixd A = spd_test_matrix(200);
+  const size_t threads = sabai::num_threads();
+  sabai::set_num_threads(3);
+  const sabai::DynamicCholeskyDecomposition blocked(A);
+  const sabai::DynamicCholeskyDecomposition tiled(A, sabai::Execution::Tiled);
+  const sabai::DynamicPackedCholeskyDecomposition packed(
+      A, sabai::Execution::Tiled);
+  sabai::set_num_threads(threads);
+
+  ASSERT_LT(max_difference(tiled.cholesky, blocked.cholesky), 1e-12);
+  for (size_t i = static_cast<size_t>(0); i < A.length(); ++i) {
+    for (size_t j = i; j < A.length(); ++j) {
+      ASSERT_EQ(packed.factors(i, j), tiled.cholesky(i, j));
+    }
+  }
+}
+
+TEST(DynamicLUDecomposition, Tiled) {
+  const size_t threads = sabai::num_threads();
+  sabai::set_num_threads(3);
+  // Square, tall and wide, each with a partial tile at the end.
+  for (const auto &[rows, columns] : {std::pair<size_t, size_t>{200, 200},
+                                      {200, 150},
+                                      {150, 200}}) {
+    const sabai::DynamicMatrixd A = lu_test_matrix(rows, columns);
+    const sabai::DynamicLUDecomposition blocked(A);
+    const sabai::DynamicLUDecomposition tiled(A, sabai::Execution::Tiled);
+    ASSERT_TRUE(sabai::all_equal(tiled.pivots, blocked.pivots));
+    ASSERT_LT(max_difference(tiled.L, blocked.L), 1e-12);
+    ASSERT_LT(max_difference(tiled.U, blocked.U), 1e-12);
+    ASSERT_LT(max_difference(A(tiled.P), tiled.L * tiled.U), 1e-10);
+
+    const sabai::DynamicPackedLUDecomposition packed(A,
+                                                     sabai::Execution::Tiled);
+    ASSERT_TRUE(sabai::all_equal(packed.pivots, blocked.pivots));
+  }
+  sabai::set_num_threads(threads);
+}
+
+TEST(QRDecomposition, DynamicBlocked) {
+  // Tall enough for several blocks of reflectors.
+  const sabai::DynamicMatrixd A = lu_test_matrix(150, 100);
+  const sabai::DynamicQRDecomposition qr(A);
+  const sabai::DynamicMatrixd Q = qr.Q();
+  const sabai::DynamicMatrixd R = qr.R();
+  ASSERT_LT(max_difference(Q * R, A), 1e-10);
+  const sabai::DynamicMatrixd Qt(Q.view().transposed());
+  const sabai::DynamicMatrixd QtQ = Qt * Q;
+  ASSERT_LT(max_difference(QtQ, sabai::Identity<double>(150)), 1e-10);
+  for (size_t i = static_cast<size_t>(0); i < R.length(); ++i) {
+    for (size_t j = static_cast<size_t>(0); j < std::min(i, R.shape(1));
+         ++j) {
+      ASSERT_EQ(R(i, j), 0.0);
+    }
+  }
+}
+
+TEST(QRDecomposition, LeastSquares) {
+  // The residual of a least-squares solution is orthogonal to the columns.
+  const sabai::DynamicMatrixd A = lu_test_matrix(120, 40);
+  sabai::DynamicVectord b(A.length());
+  for (size_t i = static_cast<size_t>(0); i < b.length(); ++i) {
+    b(i) = static_cast<double>(i % 5) - 2.0;
+  }
+  const sabai::DynamicQRDecomposition qr(A);
+  const sabai::DynamicVectord residual = A * sabai::solve(qr, b) - b;
+  const sabai::DynamicMatrixd At(A.view().transposed());
+  const sabai::DynamicVectord normal = At * residual;
+  for (size_t j = static_cast<size_t>(0); j < normal.length(); ++j) {
+    ASSERT_LT(std::abs(normal(j)), 1e-9);
+  }
+}
+
+TEST(QRDecomposition, LeastSquaresSolveInto) {
+  const sabai::DynamicMatrixd A = lu_test_matrix(120, 40);
+  sabai::DynamicVectord b(A.length());
+  for (size_t i = static_cast<size_t>(0); i < b.length(); ++i) {
+    b(i) = static_cast<double>(i % 5) - 2.0;
+  }
+  const sabai::DynamicQRDecomposition qr(A);
+  sabai::DynamicVectord expected(b);
+  sabai::solve_inplace(qr, expected);
+  sabai::DynamicVectord x(A.shape(1));
+  sabai::solve_into(qr, b, x);
+  for (size_t i = static_cast<size_t>(0); i < x.length(); ++i) {
+    ASSERT_EQ(x(i), expected(i));
+  }
+  sabai::DynamicVectord workspace(b.length() - 1);
+  ASSERT_THROW(sabai::solve_into(qr, b, x, workspace.view()),
+               sabai::MismatchedLength);
+  sabai::DynamicVectord long_x(b.length());
+  ASSERT_THROW(sabai::solve_into(qr, b, long_x), sabai::MismatchedLength);
+}
+
+TEST(QRDecomposition, StaticSolve) {
+  const sabai::StaticArrayd<3, 3> A = {
+      {1.0, 1.0, 1.0}, {1.0, 4.0, 2.0}, {4.0, 7.0, 8.0}};
+  const sabai::StaticVectord<3> b = {1.0, 3.0, 9.0};
+  const sabai::QRDecomposition qr(A);
+  const auto QR = qr.Q() * qr.R();
+  const auto solution = sabai::solve(qr, b);
+  const auto Ax = A * solution;
+  for (size_t i = static_cast<size_t>(0); i < 3; ++i) {
+    ASSERT_NEAR(Ax(i), b(i), 1e-12);
+    for (size_t j = static_cast<size_t>(0); j < 3; ++j) {
+      ASSERT_NEAR(QR(i, j), A(i, j), 1e-12);
+    }
+  }
+}
+
+// Checks every column of X against the single right-hand side solve.
+template <typename Decomposition>
+void expect_matches_vector_solves(const Decomposition &decomposition,
+                                  const sabai::DynamicMatrixd &B,
+                                  const sabai::DynamicMatrixd &X) {
+  for (size_t j = static_cast<size_t>(0); j < B.shape(1); ++j) {
+    const sabai::DynamicVectord b(B.view().column(j));
+    const sabai::DynamicVectord x = sabai::solve(decomposition, b);
+    ASSERT_EQ(x.length(), X.length());
+    for (size_t i = static_cast<size_t>(0); i < x.length(); ++i) {
+      ASSERT_NEAR(X(i, j), x(i), 1e-9);
+    }
+  }
+}
+
+TEST(Trsm, MatchesMultiplication) {
+  // Lower and, through a transposed view, upper factors spanning blocks.
+  const size_t n = 150;
+  sabai::DynamicMatrixd L = lu_test_matrix(n, n);
+  for (size_t i = static_cast<size_t>(0); i < n; ++i) {
+    L(i, i) += 4.0;
+  }
+  const sabai::DynamicMatrixd B = lu_test_matrix(n, 20);
+  const sabai::DynamicMatrixd X = sabai::forward_substitution_solve(L, B);
+  const sabai::DynamicMatrixd lower = sabai::tril(L);
+  ASSERT_LT(max_difference(lower * X, B), 1e-10);
+
+  sabai::DynamicMatrixd Y(B);
+  sabai::trsm<double>(sabai::Triangle::Upper, false, L.view().transposed(),
+                      Y.view());
+  const sabai::DynamicMatrixd upper(lower.view().transposed());
+  ASSERT_LT(max_difference(upper * Y, B), 1e-10);
+}
+
+TEST(DynamicLUDecomposition, MultipleRightHandSides) {
+  const sabai::DynamicMatrixd A = lu_test_matrix(150, 150);
+  const sabai::DynamicMatrixd B = lu_test_matrix(150, 30);
+  const sabai::DynamicLUDecomposition lu(A);
+  const sabai::DynamicMatrixd X = sabai::solve(lu, B);
+  ASSERT_LT(max_difference(A * X, B), 1e-8);
+  expect_matches_vector_solves(lu, B, X);
+}
+
+TEST(DynamicCholesky, MultipleRightHandSides) {
+  const sabai::DynamicMatrixd A = spd_test_matrix(100);
+  const sabai::DynamicMatrixd B = lu_test_matrix(100, 12);
+  const sabai::DynamicCholeskyDecomposition cholesky(A);
+  const sabai::DynamicMatrixd X = sabai::solve(cholesky, B);
+  ASSERT_LT(max_difference(A * X, B), 1e-8);
+  expect_matches_vector_solves(cholesky, B, X);
+}
+
+TEST(QRDecomposition, MultipleRightHandSides) {
+  const sabai::DynamicMatrixd A = lu_test_matrix(120, 70);
+  const sabai::DynamicMatrixd B = lu_test_matrix(120, 9);
+  const sabai::DynamicQRDecomposition qr(A);
+  expect_matches_vector_solves(qr, B, sabai::solve(qr, B));
+}
+
+TEST(PackedLUDecomposition, MatchesDynamicLU) {
+  const sabai::DynamicMatrixd A = lu_test_matrix(150, 150);
+  const sabai::DynamicMatrixd B = lu_test_matrix(150, 12);
+  const sabai::DynamicLUDecomposition lu(A);
+  const sabai::DynamicPackedLUDecomposition packed(A);
+  for (size_t i = static_cast<size_t>(0); i < A.length(); ++i) {
+    for (size_t j = static_cast<size_t>(0); j < A.length(); ++j) {
+      ASSERT_EQ(packed.factors(i, j), j < i ? lu.L(i, j) : lu.U(i, j));
+    }
+  }
+  const sabai::DynamicMatrixd X = sabai::solve(packed, B);
+  ASSERT_LT(max_difference(X, sabai::solve(lu, B)), 1e-12);
+  expect_matches_vector_solves(packed, B, X);
+}
+
+TEST(PackedCholesky, MatchesDynamicCholesky) {
+  const sabai::DynamicMatrixd A = spd_test_matrix(100);
+  const sabai::DynamicMatrixd B = lu_test_matrix(100, 5);
+  const sabai::DynamicCholeskyDecomposition cholesky(A);
+  const sabai::DynamicPackedCholeskyDecomposition packed(A);
+  for (size_t i = static_cast<size_t>(0); i < A.length(); ++i) {
+    for (size_t j = static_cast<size_t>(0); j < A.length(); ++j) {
+      const double expected = j < i ? A(i, j) : cholesky.cholesky(i, j);
+      ASSERT_EQ(packed.factors(i, j), expected);
+    }
+  }
+  const sabai::DynamicMatrixd X = sabai::solve(packed, B);
+  ASSERT_LT(max_difference(A * X, B), 1e-8);
+  expect_matches_vector_solves(packed, B, X);
+  sabai::DynamicMatrixd short_B = lu_test_matrix(99, 5);
+  ASSERT_THROW(sabai::solve_inplace(packed, short_B), sabai::MismatchedLength);
+}
+
+TEST(DynamicDecompositions, FactorWithWorkspace) {
+  const sabai::DynamicMatrixd A = spd_test_matrix(100);
+  const sabai::DynamicMatrixd B = lu_test_matrix(150, 100);
+  sabai::DynamicLUDecomposition<double> lu;
+  sabai::DynamicCholeskyDecomposition<double> cholesky;
+  sabai::DynamicQRDecomposition<double> qr;
+  sabai::DynamicVectord workspace(std::max(
+      {sabai::DynamicLUDecomposition<double>::workspace_size(100, 100),
+       sabai::DynamicCholeskyDecomposition<double>::workspace_size(100, 100),
+       sabai::DynamicQRDecomposition<double>::workspace_size(150, 100)}));
+  // Refactoring a different matrix of another shape replaces the factors.
+  lu.factor(B, workspace.view());
+  qr.factor(A, workspace.view());
+  lu.factor(A, workspace.view());
+  cholesky.factor(A, workspace.view());
+  qr.factor(B, workspace.view());
+
+  const sabai::DynamicLUDecomposition expected_lu(A);
+  ASSERT_EQ(max_difference(lu.L, expected_lu.L), 0.0);
+  ASSERT_EQ(max_difference(lu.U, expected_lu.U), 0.0);
+  ASSERT_TRUE(sabai::all_equal(lu.P, expected_lu.P));
+  ASSERT_TRUE(sabai::all_equal(lu.pivots, expected_lu.pivots));
+  const sabai::DynamicCholeskyDecomposition expected_cholesky(A);
+  ASSERT_EQ(max_difference(cholesky.cholesky, expected_cholesky.cholesky),
+            0.0);
+  const sabai::DynamicQRDecomposition expected_qr(B);
+  ASSERT_EQ(max_difference(qr.factors, expected_qr.factors), 0.0);
+  ASSERT_TRUE(sabai::all_equal(qr.tau, expected_qr.tau));
+
+  sabai::DynamicVectord too_small(
+      sabai::DynamicQRDecomposition<double>::workspace_size(150, 100) - 1);
+  ASSERT_THROW(qr.factor(B, too_small.view()), sabai::MismatchedLength);
+}
+
+TEST(DynamicLUDecomposition, ColumnMajor) {
+  // Spans several panels, with a partial one at the end.
+  const sabai::DynamicMatrixd A = lu_test_matrix(150, 150);
+  sabai::DynamicMatrixd factors(sabai::Layout::ColumnMajor, 150, 150);
+  for (size_t i = static_cast<size_t>(0); i < 150; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < 150; ++j) {
+      factors(i, j) = A(i, j);
+    }
+  }
+  const sabai::DynamicLUDecomposition expected(A);
+  const sabai::DynamicLUDecomposition lu(factors);
+  ASSERT_EQ(lu.U.layout(), sabai::Layout::ColumnMajor);
+  ASSERT_TRUE(sabai::all_equal(lu.pivots, expected.pivots));
+  ASSERT_LT(max_difference(lu.L, expected.L), 1e-12);
+  ASSERT_LT(max_difference(lu.U, expected.U), 1e-12);
+
+  // Factoring a view of column-major data in place.
+  std::vector<double> buffer(150 * 150);
+  const sabai::DynamicArrayView<double, 2> view =
+      sabai::column_major_view(buffer.data(), 150, 150);
+  sabai::assign(view, A.view());
+  sabai::DynamicVector<size_t> pivots(150);
+  sabai::lu_factor_inplace(view, pivots.view());
+  ASSERT_TRUE(sabai::all_equal(pivots, expected.pivots));
+  for (size_t i = static_cast<size_t>(0); i < 150; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < 150; ++j) {
+      ASSERT_NEAR(view(i, j), j < i ? expected.L(i, j) : expected.U(i, j),
+                  1e-12);
+    }
+  }
+}
+
+TEST(StaticDecompositions, MultipleRightHandSides) {
+  const sabai::StaticArrayd<3, 3> A = {
+      {4.0, 2.0, 2.0}, {2.0, 5.0, 3.0}, {2.0, 3.0, 6.0}};
+  const sabai::StaticArrayd<3, 2> B = {{2.0, 1.0}, {1.0, 0.0}, {3.0, -1.0}};
+  const auto X_lu = sabai::solve(sabai::LUDecomposition(A), B);
+  const auto X_cholesky = sabai::solve(sabai::CholeskyDecomposition(A), B);
+  const auto X_qr = sabai::solve(sabai::QRDecomposition(A), B);
+  const auto AX = A * X_lu;
+  for (size_t i = static_cast<size_t>(0); i < 3; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < 2; ++j) {
+      ASSERT_NEAR(AX(i, j), B(i, j), 1e-12);
+      ASSERT_NEAR(X_cholesky(i, j), X_lu(i, j), 1e-12);
+      ASSERT_NEAR(X_qr(i, j), X_lu(i, j), 1e-12);
+    }
+  }
 }
 
 TEST(SwapElements, Integers) {
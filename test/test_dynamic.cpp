@@ -1,6 +1,9 @@
 #include "sabai/dynamic.hpp"
+#include "sabai/operators.hpp"
 #include <gtest/gtest.h>
 
+#include <cstdint>
+
 class InitializerListDynamicVector : public ::testing::Test {
 protected:
   int values[5] = {1, 2, 3, 4, 5};
@@ -68,7 +71,7 @@ TEST_F(UninitializedDynamicVectorFixture, VectoriLength0) {
 }
 
 TEST_F(UninitializedDynamicVectorFixture, VectoriOutOfRangeIndex) {
-  ASSERT_THROW(vectori(0), sabai::OutOfRange);
+  ASSERT_THROW(vectori.at(0), sabai::OutOfRange);
 }
 
 TEST_F(UninitializedDynamicVectorFixture, VectorfLength0) {
@@ -76,7 +79,7 @@ TEST_F(UninitializedDynamicVectorFixture, VectorfLength0) {
 }
 
 TEST_F(UninitializedDynamicVectorFixture, VectorfOutOfRangeIndex) {
-  ASSERT_THROW(vectorf(0), sabai::OutOfRange);
+  ASSERT_THROW(vectorf.at(0), sabai::OutOfRange);
 }
 
 class DynamicVectorFixture : public ::testing::Test {
@@ -189,7 +192,7 @@ TEST_F(DynamicVectorFixture, FillInt) {
 }
 
 TEST_F(DynamicVectorFixture, IntIndexOutOfRange) {
-  ASSERT_THROW(vectori(length), sabai::OutOfRange);
+  ASSERT_THROW(vectori.at(length), sabai::OutOfRange);
 }
 
 class DynamicMatrixFixture : public ::testing::Test {
@@ -279,15 +282,15 @@ TEST_F(DynamicMatrixFixture, SetElementd) {
 }
 
 TEST_F(DynamicMatrixFixture, RowIndexOutOfRange) {
-  ASSERT_THROW(matrix(2), sabai::OutOfRange);
+  ASSERT_THROW(matrix.at(2), sabai::OutOfRange);
 }
 
 TEST_F(DynamicMatrixFixture, ElementIndexOutOfRange) {
-  ASSERT_THROW(matrix(0, 2), sabai::OutOfRange);
+  ASSERT_THROW(matrix.at(0, 2), sabai::OutOfRange);
 }
 
 TEST_F(DynamicMatrixFixture, RowIndexOutOfRangeElementOk) {
-  ASSERT_THROW(matrix(2, 0), sabai::OutOfRange);
+  ASSERT_THROW(matrix.at(2, 0), sabai::OutOfRange);
 }
 
 TEST_F(DynamicMatrixFixture, Filla) {
@@ -316,6 +319,62 @@ TEST_F(DynamicMatrixFixture, FillDouble) {
   ASSERT_EQ(matrixd(1, 1), value);
 }
 
+TEST_F(DynamicMatrixFixture, ContiguousRows) {
+  ASSERT_EQ(&matrix(1, 0), &matrix(0, 0) + length[1]);
+  ASSERT_EQ(matrix.data(), &matrix(0, 0));
+  ASSERT_EQ(matrix.size(), length[0] * length[1]);
+}
+
+TEST_F(DynamicMatrixFixture, Strides) {
+  ASSERT_EQ(matrix.stride(0), length[1]);
+  ASSERT_EQ(matrix.stride(1), 1);
+}
+
+TEST_F(DynamicMatrixFixture, AssignRow) {
+  sabai::DynamicVectori row = {c, d};
+  matrix(0) = row;
+  ASSERT_EQ(matrix(0, 0), c);
+  ASSERT_EQ(matrix(0, 1), d);
+}
+
+TEST_F(DynamicMatrixFixture, RaggedInitializerList) {
+  ASSERT_THROW(matrix.fill({{a, b}, {c}}), sabai::MismatchedLength);
+}
+
+TEST_F(DynamicMatrixFixture, ConstRowIsView) {
+  const auto &const_matrix = matrix;
+  ASSERT_EQ(&const_matrix(1)(0), &matrix(1, 0));
+}
+
+TEST_F(DynamicMatrixFixture, Column) {
+  matrix.fill({{a, b}, {c, d}});
+  auto column = matrix.column(1);
+  ASSERT_EQ(column.length(), length[0]);
+  ASSERT_EQ(column(0), b);
+  ASSERT_EQ(column(1), d);
+  column(0) = a;
+  ASSERT_EQ(matrix(0, 1), a);
+}
+
+TEST_F(DynamicMatrixFixture, ColumnOutOfRange) {
+  ASSERT_THROW(matrix.column(2), sabai::OutOfRange);
+}
+
+TEST_F(DynamicMatrixFixture, Block) {
+  sabai::DynamicMatrixi big = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+  auto block = big.block(1, 1, 2, 2);
+  sabai::DynamicMatrixi answer = {{5, 6}, {8, 9}};
+  ASSERT_TRUE(sabai::all_equal(block, answer));
+  ASSERT_THROW(big.block(2, 0, 2, 2), sabai::OutOfRange);
+}
+
+TEST_F(DynamicMatrixFixture, CopyFromView) {
+  matrix.fill({{a, b}, {c, d}});
+  sabai::DynamicVectori column = matrix.column(0);
+  sabai::DynamicVectori answer = {a, c};
+  ASSERT_TRUE(sabai::all_equal(column, answer));
+}
+
 class DynamicTensorFixture : public ::testing::Test {
 protected:
   int shape[3] = {2, 2, 2};
@@ -378,6 +437,15 @@ TEST_F(DynamicTensorFixture, SetElement) {
   ASSERT_EQ(tensor(0, 0, 0), values[0]);
 }
 
+TEST_F(DynamicTensorFixture, ContiguousMatrices) {
+  ASSERT_EQ(&tensor(1, 0, 0), &tensor(0, 0, 0) + shape[1] * shape[2]);
+  ASSERT_EQ(tensor.shape(2), shape[2]);
+}
+
+TEST_F(DynamicTensorFixture, ElementIndexOutOfRange) {
+  ASSERT_THROW(tensor.at(0, 2, 0), sabai::OutOfRange);
+}
+
 class EmptyLikeDynamicArray : public ::testing::Test {
 protected:
   sabai::DynamicVectori vectori{{1, 2, 3, 4, 5}};
@@ -437,4 +505,166 @@ TEST(ARange, ARangeDynamic) {
   sabai::DynamicVector<size_t> answer = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
 
   ASSERT_TRUE(sabai::all_equal(vector, answer));
-}
\ No newline at end of file
+}
+TEST_F(DynamicTensorFixture, AtMatchesOperator) {
+  tensor.at(1, 0, 1) = 9;
+  ASSERT_EQ(tensor(1, 0, 1), 9);
+  ASSERT_EQ(tensor.at(1, 0).at(1), 9);
+  ASSERT_EQ(tensor.view().at(1, 0, 1), 9);
+  ASSERT_THROW(tensor.at(1).at(0, 2), sabai::OutOfRange);
+  ASSERT_THROW(tensor.view().at(2), sabai::OutOfRange);
+}
+
+TEST_F(DynamicTensorFixture, OperatorChecksFollowPolicy) {
+  if constexpr (sabai::bounds_checked) {
+    ASSERT_THROW(tensor(2, 0, 0), sabai::OutOfRange);
+    ASSERT_THROW(tensor(0)(0, 2), sabai::OutOfRange);
+  } else {
+    ASSERT_NO_THROW(tensor(1, 1, 1));
+  }
+}
+
+TEST(AlignedAllocation, BuffersStartOnACacheLine) {
+  const sabai::DynamicVectord vector(3);
+  const sabai::DynamicVectorf floats(5);
+  const sabai::DynamicMatrixi matrix(3, 7);
+  const sabai::DynamicArrayd<3> tensor(2, 3, 5);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(vector.data()) % 64, 0);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(floats.data()) % 64, 0);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(matrix.data()) % 64, 0);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(tensor.data()) % 64, 0);
+}
+
+TEST(PaddedRows, LeadingDimension) {
+  const sabai::DynamicMatrixd narrow(sabai::RowPadding::Aligned, 5, 10);
+  ASSERT_EQ(narrow.stride(0), 16);
+  ASSERT_EQ(narrow.size(), 80);
+  // 64 doubles are 512 bytes, so one more cache line is added.
+  const sabai::DynamicMatrixd wide(sabai::RowPadding::Aligned, 3, 64);
+  ASSERT_EQ(wide.stride(0), 72);
+  const sabai::DynamicMatrixf floats(sabai::RowPadding::Aligned, 4, 3);
+  ASSERT_EQ(floats.stride(0), 16);
+  const sabai::DynamicArrayd<3> tensor(sabai::RowPadding::Aligned, 2, 3, 5);
+  ASSERT_EQ(tensor.stride(2), 1);
+  ASSERT_EQ(tensor.stride(1), 8);
+  ASSERT_EQ(tensor.stride(0), 24);
+  for (size_t row = static_cast<size_t>(0); row < 5; ++row) {
+    const double *start = narrow.data() + row * narrow.stride(0);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(start) % 64, 0);
+  }
+  const sabai::DynamicMatrixd unpadded(5, 10);
+  ASSERT_EQ(unpadded.stride(0), 10);
+  ASSERT_EQ(unpadded.padding(), sabai::RowPadding::None);
+}
+
+TEST(PaddedRows, CopiesAndExpressions) {
+  sabai::DynamicMatrixd padded(sabai::RowPadding::Aligned, 3, 5);
+  sabai::DynamicMatrixd plain(3, 5);
+  for (size_t i = static_cast<size_t>(0); i < 3; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < 5; ++j) {
+      padded(i, j) = static_cast<double>(i * 5 + j);
+      plain(i, j) = 2.0 * static_cast<double>(i * 5 + j);
+    }
+  }
+  const sabai::DynamicMatrixd copy = padded;
+  ASSERT_EQ(copy.padding(), sabai::RowPadding::Aligned);
+  ASSERT_EQ(copy.stride(0), 8);
+
+  const sabai::DynamicMatrixd sum = padded + plain;
+  padded += plain;
+  sabai::DynamicMatrixd filled(3, 5);
+  filled.fill(copy);
+  for (size_t i = static_cast<size_t>(0); i < 3; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < 5; ++j) {
+      ASSERT_EQ(copy(i, j), static_cast<double>(i * 5 + j));
+      ASSERT_EQ(filled(i, j), copy(i, j));
+      ASSERT_EQ(sum(i, j), 3.0 * static_cast<double>(i * 5 + j));
+      ASSERT_EQ(padded(i, j), sum(i, j));
+    }
+  }
+  plain = copy;
+  ASSERT_EQ(plain.stride(0), 8);
+  ASSERT_EQ(plain(2, 4), 14.0);
+}
+
+TEST(SmallBuffer, ShortVectorsStayInline) {
+  sabai::DynamicVectord short_vector = {1.0, 2.0, 3.0};
+  const double *inline_data = short_vector.data();
+  ASSERT_GE(reinterpret_cast<std::uintptr_t>(inline_data),
+            reinterpret_cast<std::uintptr_t>(&short_vector));
+  ASSERT_LT(reinterpret_cast<std::uintptr_t>(inline_data),
+            reinterpret_cast<std::uintptr_t>(&short_vector + 1));
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(inline_data) % 64, 0);
+
+  // Growing past the capacity moves to the heap, and shrinking back in.
+  const size_t capacity = sabai::DynamicVectord::inline_capacity;
+  ASSERT_EQ(capacity, 16);
+  short_vector.allocate(capacity + 1);
+  ASSERT_NE(short_vector.data(), inline_data);
+  short_vector.allocate(capacity);
+  ASSERT_EQ(short_vector.data(), inline_data);
+
+  short_vector.fill(4.0);
+  const sabai::DynamicVectord moved = std::move(short_vector);
+  ASSERT_EQ(short_vector.length(), 0);
+  ASSERT_EQ(moved.length(), capacity);
+  ASSERT_EQ(moved(capacity - 1), 4.0);
+  ASSERT_NE(moved.data(), inline_data);
+}
+
+TEST(ColumnMajor, Strides) {
+  const sabai::DynamicMatrixd matrix(sabai::Layout::ColumnMajor, 3, 5);
+  ASSERT_EQ(matrix.layout(), sabai::Layout::ColumnMajor);
+  ASSERT_EQ(matrix.stride(0), 1);
+  ASSERT_EQ(matrix.stride(1), 3);
+  const sabai::DynamicMatrixd padded(sabai::Layout::ColumnMajor,
+                                     sabai::RowPadding::Aligned, 3, 5);
+  ASSERT_EQ(padded.stride(0), 1);
+  ASSERT_EQ(padded.stride(1), 8);
+  ASSERT_EQ(padded.size(), 40);
+  const sabai::DynamicArrayd<3> tensor(sabai::Layout::ColumnMajor, 2, 3, 4);
+  ASSERT_EQ(tensor.stride(0), 1);
+  ASSERT_EQ(tensor.stride(1), 2);
+  ASSERT_EQ(tensor.stride(2), 6);
+}
+
+TEST(ColumnMajor, MatchesRowMajor) {
+  sabai::DynamicMatrixd column_major(sabai::Layout::ColumnMajor, 3, 4);
+  sabai::DynamicMatrixd row_major(3, 4);
+  for (size_t i = static_cast<size_t>(0); i < 3; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < 4; ++j) {
+      column_major(i, j) = static_cast<double>(i * 4 + j);
+      row_major(i, j) = static_cast<double>(i * 4 + j);
+    }
+  }
+  // Element (1, 2) follows the first column and two more elements.
+  ASSERT_EQ(column_major.data()[2 * 3 + 1], 6.0);
+  const sabai::DynamicMatrixd copy = column_major;
+  ASSERT_EQ(copy.layout(), sabai::Layout::ColumnMajor);
+  const sabai::DynamicMatrixd sum = column_major + row_major;
+  const sabai::DynamicVector<size_t> order = {2, 0};
+  const sabai::DynamicMatrixd gathered = column_major(order);
+  ASSERT_EQ(gathered.layout(), sabai::Layout::ColumnMajor);
+  for (size_t j = static_cast<size_t>(0); j < 4; ++j) {
+    ASSERT_EQ(gathered(0, j), row_major(2, j));
+    ASSERT_EQ(gathered(1, j), row_major(0, j));
+    for (size_t i = static_cast<size_t>(0); i < 3; ++i) {
+      ASSERT_EQ(copy(i, j), row_major(i, j));
+      ASSERT_EQ(sum(i, j), 2.0 * row_major(i, j));
+    }
+  }
+}
+
+TEST(ColumnMajor, ViewsOfExternalData) {
+  // A 2 x 3 Fortran-style buffer with a leading dimension of 4.
+  double buffer[12] = {1.0, 4.0, 0.0, 0.0, 2.0, 5.0,
+                       0.0, 0.0, 3.0, 6.0, 0.0, 0.0};
+  const sabai::DynamicArrayView<double, 2> view =
+      sabai::column_major_view(buffer, 2, 3, 4);
+  ASSERT_EQ(view(1, 2), 6.0);
+  view(0, 1) = 7.0;
+  ASSERT_EQ(buffer[4], 7.0);
+  const sabai::DynamicArrayView<double, 2> rows =
+      sabai::row_major_view(buffer, 3, 4);
+  ASSERT_EQ(rows(1, 0), 7.0);
+}
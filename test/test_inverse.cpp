@@ -0,0 +1,103 @@
+#include "sabai/inverse.hpp"
+#include "sabai/products.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+namespace {
+template <typename T, size_t N>
+T max_difference(const sabai::StaticMatrix<T, N, N> &left,
+                 const sabai::StaticMatrix<T, N, N> &right) {
+  T difference = static_cast<T>(0);
+  for (size_t i = 0; i < N; ++i) {
+    for (size_t j = 0; j < N; ++j) {
+      difference = std::max(difference, std::abs(left(i, j) - right(i, j)));
+    }
+  }
+  return difference;
+}
+
+template <size_t N> sabai::StaticMatrixd<N, N> test_matrix() {
+  sabai::StaticMatrixd<N, N> A;
+  for (size_t i = 0; i < N; ++i) {
+    for (size_t j = 0; j < N; ++j) {
+      A(i, j) = static_cast<double>((i * 7 + j * 3 + i * j) % 5) - 2.0 +
+                (i == j ? 4.0 : 0.0);
+    }
+  }
+  return A;
+}
+
+template <size_t N> void expect_inverse_and_solve() {
+  const sabai::StaticMatrixd<N, N> A = test_matrix<N>();
+  const sabai::StaticMatrixd<N, N> identity = sabai::Identity<double, N>();
+  ASSERT_LT(max_difference(A * sabai::inverse(A), identity), 1e-12);
+  sabai::StaticMatrixd<N, N> scaled = identity;
+  for (size_t i = 0; i < N; ++i) {
+    scaled(i, i) = sabai::determinant(A);
+  }
+  ASSERT_LT(max_difference(A * sabai::adjugate(A), scaled), 1e-10);
+
+  sabai::StaticVectord<N> b;
+  for (size_t i = 0; i < N; ++i) {
+    b(i) = static_cast<double>(i) - 1.5;
+  }
+  const sabai::StaticVectord<N> x = sabai::solve(A, b);
+  const sabai::StaticVectord<N> expected =
+      sabai::solve(sabai::LUDecomposition(A), b);
+  for (size_t i = 0; i < N; ++i) {
+    ASSERT_NEAR(x(i), expected(i), 1e-12);
+  }
+}
+} // namespace
+
+TEST(ClosedForm, Determinants) {
+  constexpr sabai::StaticMatrixd<2, 2> A = {{1.0, 2.0}, {3.0, 4.0}};
+  static_assert(sabai::determinant(A) == -2.0);
+  const sabai::StaticMatrixd<3, 3> B = {
+      {2.0, 0.0, 1.0}, {1.0, 3.0, 2.0}, {1.0, 1.0, 2.0}};
+  ASSERT_DOUBLE_EQ(sabai::determinant(B), 6.0);
+  // The determinant of the LU factors, with the sign of the permutation.
+  const sabai::StaticMatrixd<4, 4> C = test_matrix<4>();
+  const sabai::LUDecomposition lu(C);
+  double expected = 1.0;
+  sabai::StaticVector<size_t, 4> P = lu.P;
+  for (size_t i = 0; i < 4; ++i) {
+    expected *= lu.U(i, i);
+    while (P(i) != i) {
+      sabai::swap(P(i), P(P(i)));
+      expected = -expected;
+    }
+  }
+  ASSERT_NEAR(sabai::determinant(C), expected, 1e-10);
+}
+
+TEST(ClosedForm, InverseAndSolve) {
+  expect_inverse_and_solve<2>();
+  expect_inverse_and_solve<3>();
+  expect_inverse_and_solve<4>();
+}
+
+TEST(ClosedForm, IllConditionedFallsBackToLU) {
+  // Nearly singular, so the adjugate would lose most of its digits.
+  const sabai::StaticMatrixd<3, 3> A = {
+      {1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}, {7.0, 8.0, 9.0 + 1e-9}};
+  ASSERT_FALSE(sabai::closed_form_conditioned(A, sabai::determinant(A)));
+  const sabai::StaticMatrixd<3, 3> expected = sabai::solve(
+      sabai::LUDecomposition(A), sabai::StaticMatrixd<3, 3>(
+                                     sabai::Identity<double, 3>()));
+  ASSERT_TRUE(sabai::all_equal(sabai::inverse(A), expected));
+}
+
+TEST(ClosedForm, LargeEntriesKeepTheClosedForm) {
+  // Squaring the determinant or the row norms of these would overflow.
+  const sabai::StaticMatrixd<4, 4> A = 1e70 * test_matrix<4>();
+  ASSERT_TRUE(sabai::closed_form_conditioned(A, sabai::determinant(A)));
+  const sabai::StaticMatrixd<2, 2> B = {{1e150, 2e150}, {3e150, 4e150}};
+  ASSERT_TRUE(sabai::closed_form_conditioned(B, sabai::determinant(B)));
+  const sabai::StaticVectord<2> x =
+      sabai::solve(B, sabai::StaticVectord<2>{5e150, 11e150});
+  ASSERT_NEAR(x(0), 1.0, 1e-12);
+  ASSERT_NEAR(x(1), 2.0, 1e-12);
+}
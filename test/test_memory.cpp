@@ -0,0 +1,81 @@
+#include "sabai/dynamic.hpp"
+#include "sabai/gemm.hpp"
+#include "sabai/memory.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <memory_resource>
+
+TEST(MemoryResource, DefaultsToHeap) {
+  ASSERT_EQ(sabai::current_memory_resource(), sabai::heap_resource());
+  const sabai::DynamicVectord a = {1.0, 2.0};
+  ASSERT_EQ(a.resource(), sabai::heap_resource());
+}
+
+TEST(MemoryResource, ScopeIsRestored) {
+  sabai::Arena arena;
+  {
+    const sabai::MemoryResourceScope scope(&arena);
+    ASSERT_EQ(sabai::current_memory_resource(), &arena);
+    {
+      sabai::Arena inner;
+      const sabai::MemoryResourceScope nested(&inner);
+      ASSERT_EQ(sabai::current_memory_resource(), &inner);
+    }
+    ASSERT_EQ(sabai::current_memory_resource(), &arena);
+  }
+  ASSERT_EQ(sabai::current_memory_resource(), sabai::heap_resource());
+}
+
+TEST(MemoryResource, ArraysKeepTheirResource) {
+  sabai::Arena arena;
+  sabai::DynamicMatrixd outside = {{1.0, 2.0}, {3.0, 4.0}};
+  {
+    const sabai::MemoryResourceScope scope(&arena);
+    sabai::DynamicMatrixd inside = {{5.0, 6.0}, {7.0, 8.0}};
+    ASSERT_EQ(inside.resource(), &arena);
+    // Growing an array allocates from the resource it was constructed with.
+    outside.allocate(3, 3);
+    ASSERT_EQ(outside.resource(), sabai::heap_resource());
+    sabai::DynamicMatrixd moved = std::move(inside);
+    ASSERT_EQ(moved.resource(), &arena);
+    ASSERT_EQ(moved(1, 0), 7.0);
+  }
+  ASSERT_EQ(outside.shape(0), 3);
+}
+
+TEST(Arena, AlignsAllocations) {
+  sabai::Arena arena(static_cast<size_t>(128));
+  ASSERT_NE(arena.allocate(1, 1), nullptr);
+  for (const size_t alignment : {8, 16, 32, 64}) {
+    const void *pointer = arena.allocate(24, alignment);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(pointer) % alignment, 0);
+    ASSERT_NE(arena.allocate(1, 1), nullptr);
+  }
+}
+
+TEST(Arena, GrowsAndReusesBlocks) {
+  sabai::Arena arena(static_cast<size_t>(64));
+  ASSERT_EQ(arena.capacity(), 0);
+  const void *first = arena.allocate(48, 8);
+  ASSERT_NE(arena.allocate(48, 8), nullptr);
+  const void *large = arena.allocate(1024, 8);
+  const size_t capacity = arena.capacity();
+  ASSERT_GE(capacity, 64 + 1024);
+
+  arena.reset();
+  ASSERT_EQ(arena.allocate(48, 8), first);
+  ASSERT_NE(arena.allocate(48, 8), nullptr);
+  ASSERT_EQ(arena.allocate(1024, 8), large);
+  ASSERT_EQ(arena.capacity(), capacity);
+}
+
+TEST(MemoryResource, HeapBufferIgnoresScope) {
+  sabai::Arena arena;
+  const sabai::MemoryResourceScope scope(&arena);
+  sabai::DynamicArray<double, 1> buffer = sabai::heap_buffer<double>();
+  buffer.allocate(16);
+  ASSERT_EQ(buffer.resource(), sabai::heap_resource());
+  ASSERT_EQ(arena.capacity(), 0);
+}
@@ -23,4 +23,9 @@ TEST(Metric, Norm_OneVectorDynamic) {
   sabai::DynamicVectori one_vector = {1, 1, 1};
   double norm_vector = sabai::norm(one_vector);
   ASSERT_DOUBLE_EQ(norm_vector, sqrt(3.0));
+}
+
+TEST(Metric, Norm_DynamicRow) {
+  sabai::DynamicMatrixd matrix = {{3.0, 4.0}, {0.0, 1.0}};
+  ASSERT_DOUBLE_EQ(sabai::norm(matrix(0)), 5.0);
 }
\ No newline at end of file
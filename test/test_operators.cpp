@@ -225,4 +225,53 @@ TEST_F(DynamicOperatorFixture, InPlaceDivision) {
   ASSERT_EQ(vector(0), a / a);
   ASSERT_EQ(vector(1), a / a);
   ASSERT_EQ(vector(2), a / a);
-}
\ No newline at end of file
+}
+
+TEST(ViewOperators, DynamicRowPlusColumn) {
+  sabai::DynamicMatrixi matrix = {{1, 2}, {3, 4}};
+  sabai::DynamicVectori answer = {1 + 1, 2 + 3};
+  ASSERT_TRUE(sabai::all_equal(matrix(0) + matrix.column(0), answer));
+}
+
+TEST(ViewOperators, StaticBlockMinusBlock) {
+  sabai::StaticArrayi<3, 3> matrix = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+  sabai::StaticArrayi<2, 2> difference =
+      matrix.block<2, 2>(1, 1) - matrix.block<2, 2>(0, 0);
+  sabai::StaticArrayi<2, 2> answer = {{4, 4}, {4, 4}};
+  ASSERT_TRUE(sabai::all_equal(difference, answer));
+}
+TEST(ExpressionOperators, DynamicChain) {
+  sabai::DynamicVectord a = {1.0, 2.0, 3.0};
+  sabai::DynamicVectord b = {4.0, 5.0, 6.0};
+  sabai::DynamicVectord result = -(a + b) - 2.0 * a / 4.0;
+  sabai::DynamicVectord answer = {-5.5, -8.0, -10.5};
+  ASSERT_TRUE(sabai::all_equal(result, answer));
+}
+
+TEST(ExpressionOperators, HoldsTemporaries) {
+  sabai::DynamicVectord a = {1.0, 2.0};
+  auto expression = a + sabai::DynamicVectord({3.0, 4.0});
+  sabai::DynamicVectord answer = {4.0, 6.0};
+  ASSERT_TRUE(sabai::all_equal(sabai::evaluate(expression), answer));
+}
+
+TEST(ExpressionOperators, MismatchedLength) {
+  sabai::DynamicVectord a = {1.0, 2.0};
+  sabai::DynamicVectord b = {1.0, 2.0, 3.0};
+  ASSERT_THROW(a + b, sabai::MismatchedLength);
+}
+
+TEST(ExpressionOperators, StaticCompoundAssignment) {
+  sabai::StaticArrayi<2, 2> matrix = {{1, 2}, {3, 4}};
+  matrix += matrix * 2;
+  matrix -= -matrix;
+  sabai::StaticArrayi<2, 2> answer = {{6, 12}, {18, 24}};
+  ASSERT_TRUE(sabai::all_equal(matrix, answer));
+}
+
+TEST(ExpressionOperators, AssignToView) {
+  sabai::DynamicMatrixi matrix = {{1, 2}, {3, 4}};
+  matrix.column(1) = matrix.column(0) + matrix(1);
+  sabai::DynamicMatrixi answer = {{1, 4}, {3, 7}};
+  ASSERT_TRUE(sabai::all_equal(matrix, answer));
+}
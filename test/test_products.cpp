@@ -362,4 +362,237 @@ TEST_F(OuterProductFixture, DynamicVectorVector) {
                                   {dynamic_vector1(1) * dynamic_vector2(0),
                                    dynamic_vector1(1) * dynamic_vector2(1)}};
   ASSERT_TRUE(sabai::all_equal(result, answer));
-}
\ No newline at end of file
+}
+
+class ViewProductFixture : public ::testing::Test {
+protected:
+  sabai::DynamicMatrixi dynamic_matrix = {{1, 2}, {3, 4}};
+  sabai::StaticArrayi<2, 2> static_matrix = {{1, 2}, {3, 4}};
+};
+
+TEST_F(ViewProductFixture, DynamicRowDotColumn) {
+  ASSERT_EQ(sabai::dot(dynamic_matrix(1), dynamic_matrix.column(0)), 3 + 12);
+}
+
+TEST_F(ViewProductFixture, StaticRowDotColumn) {
+  ASSERT_EQ(sabai::dot(static_matrix(1), static_matrix.column(0)), 3 + 12);
+}
+
+TEST_F(ViewProductFixture, ScalarDynamicColumn) {
+  sabai::DynamicVectori answer = {2, 6};
+  ASSERT_TRUE(sabai::all_equal(2 * dynamic_matrix.column(0), answer));
+}
+
+TEST_F(ViewProductFixture, OuterColumns) {
+  sabai::DynamicMatrixi result =
+      sabai::outer(static_matrix.column(0), dynamic_matrix(0));
+  sabai::DynamicMatrixi answer = {{1, 2}, {3, 6}};
+  ASSERT_TRUE(sabai::all_equal(result, answer));
+}
+class GemmFixture : public ::testing::Test {
+protected:
+  // Sizes straddle the register tiles and the KC and MC cache blocks.
+  static constexpr size_t m = 133;
+  static constexpr size_t k = 301;
+  static constexpr size_t n = 37;
+  sabai::DynamicMatrixi A{m, k};
+  sabai::DynamicMatrixi B{k, n};
+
+  GemmFixture() {
+    for (size_t row = 0; row < m; ++row) {
+      for (size_t column = 0; column < k; ++column) {
+        A(row, column) = static_cast<int>((row * 7 + column * 3) % 11) - 5;
+      }
+    }
+    for (size_t row = 0; row < k; ++row) {
+      for (size_t column = 0; column < n; ++column) {
+        B(row, column) = static_cast<int>((row * 5 + column) % 7) - 3;
+      }
+    }
+  }
+
+  int reference(size_t row, size_t column) const {
+    int value = 0;
+    for (size_t index = 0; index < k; ++index) {
+      value += A(row, index) * B(index, column);
+    }
+    return value;
+  }
+};
+
+TEST_F(GemmFixture, MatchesReference) {
+  sabai::DynamicMatrixi result = A * B;
+  ASSERT_EQ(result.shape(0), m);
+  ASSERT_EQ(result.shape(1), n);
+  for (size_t row = 0; row < m; ++row) {
+    for (size_t column = 0; column < n; ++column) {
+      ASSERT_EQ(result(row, column), reference(row, column));
+    }
+  }
+}
+
+TEST_F(GemmFixture, TransposedViewWithAlphaBeta) {
+  // B^T * A^T, with both transposes viewed in place by swapping strides.
+  const size_t left_shape[2] = {n, k};
+  const size_t left_strides[2] = {B.stride(1), B.stride(0)};
+  const size_t right_shape[2] = {k, m};
+  const size_t right_strides[2] = {A.stride(1), A.stride(0)};
+  sabai::DynamicArrayView<const int, 2> left(B.data(), left_shape,
+                                             left_strides);
+  sabai::DynamicArrayView<const int, 2> right(A.data(), right_shape,
+                                              right_strides);
+  sabai::DynamicMatrixi result(n, m);
+  result.fill(1);
+  sabai::gemm(2, left, right, 3, result.view());
+  for (size_t row = 0; row < n; ++row) {
+    for (size_t column = 0; column < m; column += 13) {
+      int value = 0;
+      for (size_t index = 0; index < k; ++index) {
+        value += B(index, row) * A(column, index);
+      }
+      ASSERT_EQ(result(row, column), 2 * value + 3);
+    }
+  }
+}
+
+TEST_F(GemmFixture, MismatchedInnerDimension) {
+  ASSERT_THROW(B * A, sabai::MismatchedLength);
+}
+
+TEST_F(GemmFixture, ParallelMatchesReference) {
+  const size_t threads = sabai::num_threads();
+  sabai::set_num_threads(3);
+  sabai::DynamicMatrixi result = A * B;
+  sabai::set_num_threads(threads);
+  for (size_t row = 0; row < m; ++row) {
+    for (size_t column = 0; column < n; ++column) {
+      ASSERT_EQ(result(row, column), reference(row, column));
+    }
+  }
+}
+
+TEST(ParallelGemv, MatchesReference) {
+  const size_t rows = 1000;
+  const size_t columns = 300;
+  sabai::DynamicMatrixd A(rows, columns);
+  sabai::DynamicVectord x(columns);
+  for (size_t column = 0; column < columns; ++column) {
+    x(column) = static_cast<double>(column % 5);
+    for (size_t row = 0; row < rows; ++row) {
+      A(row, column) = static_cast<double>((row + column) % 3);
+    }
+  }
+  const size_t threads = sabai::num_threads();
+  sabai::set_num_threads(3);
+  sabai::DynamicVectord result = A * x;
+  sabai::set_num_threads(threads);
+  for (size_t row = 0; row < rows; ++row) {
+    ASSERT_EQ(result(row), sabai::dot(A(row), x));
+  }
+}
+
+// The unrolled float and double kernels must agree with the generic loops,
+// which int products still use. Small integers keep every sum exact.
+template <typename T, size_t M, size_t N, size_t P>
+void expect_small_product() {
+  sabai::StaticMatrix<T, M, N> left;
+  sabai::StaticMatrix<T, N, P> right;
+  sabai::StaticMatrixi<M, N> left_int;
+  sabai::StaticMatrixi<N, P> right_int;
+  sabai::StaticVector<T, N> x;
+  sabai::StaticVectori<N> x_int;
+  for (size_t i = 0; i < N; ++i) {
+    x_int(i) = static_cast<int>(i % 3) - 1;
+    x(i) = static_cast<T>(x_int(i));
+    for (size_t row = 0; row < M; ++row) {
+      left_int(row, i) = static_cast<int>((row * 5 + i * 3) % 7) - 3;
+      left(row, i) = static_cast<T>(left_int(row, i));
+    }
+    for (size_t column = 0; column < P; ++column) {
+      right_int(i, column) = static_cast<int>((i * 2 + column * 5) % 9) - 4;
+      right(i, column) = static_cast<T>(right_int(i, column));
+    }
+  }
+  const sabai::StaticMatrix<T, M, P> product = left * right;
+  const sabai::StaticMatrixi<M, P> expected = left_int * right_int;
+  const sabai::StaticVector<T, M> y = left * x;
+  const sabai::StaticVectori<M> expected_y = left_int * x_int;
+  for (size_t row = 0; row < M; ++row) {
+    ASSERT_EQ(y(row), static_cast<T>(expected_y(row)));
+    for (size_t column = 0; column < P; ++column) {
+      ASSERT_EQ(product(row, column), static_cast<T>(expected(row, column)));
+    }
+  }
+}
+
+TEST(SmallStaticProducts, Square) {
+  expect_small_product<double, 2, 2, 2>();
+  expect_small_product<double, 3, 3, 3>();
+  expect_small_product<double, 4, 4, 4>();
+  expect_small_product<double, 6, 6, 6>();
+  expect_small_product<float, 2, 2, 2>();
+  expect_small_product<float, 3, 3, 3>();
+  expect_small_product<float, 4, 4, 4>();
+  expect_small_product<float, 6, 6, 6>();
+}
+
+TEST(SmallStaticProducts, Rectangular) {
+  expect_small_product<double, 3, 4, 2>();
+  expect_small_product<double, 6, 3, 4>();
+  expect_small_product<float, 4, 6, 3>();
+  // Shapes without an unrolled kernel take the generic loops.
+  expect_small_product<double, 5, 3, 7>();
+}
+
+TEST(PaddedRows, MatrixProduct) {
+  sabai::DynamicMatrixd A(sabai::RowPadding::Aligned, 37, 64);
+  sabai::DynamicMatrixd B(sabai::RowPadding::Aligned, 64, 29);
+  sabai::DynamicMatrixd A_plain(37, 64);
+  sabai::DynamicMatrixd B_plain(64, 29);
+  for (size_t i = static_cast<size_t>(0); i < 64; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < 37; ++j) {
+      A(j, i) = A_plain(j, i) = static_cast<double>((i * 7 + j * 3) % 11);
+    }
+    for (size_t j = static_cast<size_t>(0); j < 29; ++j) {
+      B(i, j) = B_plain(i, j) = static_cast<double>((i * 5 + j) % 13);
+    }
+  }
+  const sabai::DynamicMatrixd C = A * B;
+  const sabai::DynamicMatrixd C_plain = A_plain * B_plain;
+  const sabai::DynamicVectord column(B.column(3));
+  const sabai::DynamicVectord x = A * column;
+  for (size_t i = static_cast<size_t>(0); i < 37; ++i) {
+    for (size_t j = static_cast<size_t>(0); j < 29; ++j) {
+      ASSERT_EQ(C(i, j), C_plain(i, j));
+    }
+    ASSERT_EQ(x(i), C_plain(i, 3));
+  }
+}
+
+TEST(ColumnMajor, MatrixVectorProduct) {
+  sabai::DynamicMatrixd A(37, 53);
+  sabai::DynamicMatrixd A_columns(sabai::Layout::ColumnMajor, 37, 53);
+  sabai::DynamicVectord x(53);
+  for (size_t j = static_cast<size_t>(0); j < 53; ++j) {
+    for (size_t i = static_cast<size_t>(0); i < 37; ++i) {
+      A(i, j) = A_columns(i, j) = static_cast<double>((i * 7 + j * 3) % 11);
+    }
+    x(j) = static_cast<double>(j % 5);
+  }
+  const sabai::DynamicVectord y = A * x;
+  const sabai::DynamicVectord y_columns = A_columns * x;
+  // The transpose of a row-major matrix is column-major.
+  sabai::DynamicVectord z(53);
+  sabai::gemv<double>(2.0, A.view().transposed(), y.view(), 0.0, z.view());
+  sabai::DynamicVectord z_expected(53);
+  z_expected.fill(0.0);
+  for (size_t i = static_cast<size_t>(0); i < 37; ++i) {
+    ASSERT_EQ(y_columns(i), y(i));
+    for (size_t j = static_cast<size_t>(0); j < 53; ++j) {
+      z_expected(j) += 2.0 * A(i, j) * y(i);
+    }
+  }
+  for (size_t j = static_cast<size_t>(0); j < 53; ++j) {
+    ASSERT_EQ(z(j), z_expected(j));
+  }
+}
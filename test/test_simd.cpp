@@ -0,0 +1,127 @@
+#include "sabai/operators.hpp"
+#include "sabai/products.hpp"
+#include "sabai/simd.hpp"
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+class SimdFixture : public ::testing::TestWithParam<sabai::SimdLevel> {
+protected:
+  static constexpr size_t length = 37;
+  sabai::DynamicVectord a = sabai::DynamicVectord(length);
+  sabai::DynamicVectord b = sabai::DynamicVectord(length);
+  sabai::DynamicVectorf x = sabai::DynamicVectorf(length);
+  sabai::DynamicVectorf y = sabai::DynamicVectorf(length);
+
+  void SetUp() override {
+    sabai::set_simd_level(GetParam());
+    for (size_t index = 0; index < length; ++index) {
+      a(index) = 0.5 * static_cast<double>(index) + 1.0;
+      b(index) = 3.0 - 0.25 * static_cast<double>(index);
+      x(index) = static_cast<float>(index % 7) + 1.0f;
+      y(index) = 2.0f - static_cast<float>(index % 5);
+    }
+  }
+
+  void TearDown() override {
+    sabai::set_simd_level(sabai::detect_simd_level());
+  }
+};
+
+TEST_P(SimdFixture, FusedExpression) {
+  sabai::DynamicVectord result = -(a + b) - a / 4.0 + 2.0 * b;
+  for (size_t index = 0; index < length; ++index) {
+    ASSERT_DOUBLE_EQ(result(index),
+                     -(a(index) + b(index)) - a(index) / 4.0 + 2.0 * b(index));
+  }
+}
+
+TEST_P(SimdFixture, FloatExpression) {
+  sabai::DynamicVectorf result = 1.0f / x - y * 3.0f;
+  for (size_t index = 0; index < length; ++index) {
+    ASSERT_FLOAT_EQ(result(index), 1.0f / x(index) - y(index) * 3.0f);
+  }
+}
+
+TEST_P(SimdFixture, CompoundAssignment) {
+  sabai::DynamicVectord expected = a;
+  a += 2.0 * b;
+  a *= 0.5;
+  for (size_t index = 0; index < length; ++index) {
+    ASSERT_DOUBLE_EQ(a(index), (expected(index) + 2.0 * b(index)) * 0.5);
+  }
+}
+
+TEST_P(SimdFixture, Dot) {
+  double expected = 0.0;
+  float expected_float = 0.0f;
+  for (size_t index = 0; index < length; ++index) {
+    expected += a(index) * b(index);
+    expected_float += x(index) * y(index);
+  }
+  ASSERT_NEAR(sabai::dot(a, b), expected, 1e-12);
+  ASSERT_NEAR(sabai::dot(x, y), expected_float, 1e-4);
+}
+
+TEST_P(SimdFixture, StridedColumns) {
+  sabai::DynamicMatrixd matrix(length, 2);
+  matrix.column(0) = a;
+  matrix.column(1) = b;
+  sabai::DynamicVectord result = matrix.column(0) - matrix.column(1);
+  for (size_t index = 0; index < length; ++index) {
+    ASSERT_EQ(result(index), a(index) - b(index));
+  }
+  ASSERT_DOUBLE_EQ(sabai::dot(matrix.column(0), matrix.column(1)),
+                   sabai::dot(a, b));
+}
+
+TEST_P(SimdFixture, Matrices) {
+  sabai::DynamicMatrixd left = {{1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}};
+  sabai::DynamicMatrixd right = {{0.5, 0.5, 0.5}, {1.0, 1.0, 1.0}};
+  sabai::DynamicMatrixd result = left - 2.0 * right;
+  sabai::DynamicMatrixd answer = {{0.0, 1.0, 2.0}, {2.0, 3.0, 4.0}};
+  ASSERT_TRUE(sabai::all_equal(result, answer));
+
+  sabai::StaticArrayd<2, 3> static_left = {{1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}};
+  sabai::StaticArrayd<2, 3> static_result = static_left + static_left;
+  ASSERT_EQ(static_result(1, 2), 12.0);
+}
+
+TEST_P(SimdFixture, MismatchedRowLength) {
+  sabai::DynamicMatrixd left(2, 3);
+  sabai::DynamicMatrixd right(2, 4);
+  left.fill(1.0);
+  right.fill(1.0);
+  ASSERT_THROW(sabai::DynamicMatrixd result = left + right,
+               sabai::MismatchedLength);
+}
+
+std::vector<sabai::SimdLevel> supported_levels() {
+  std::vector<sabai::SimdLevel> levels;
+  for (auto level : {sabai::SimdLevel::Scalar, sabai::SimdLevel::SSE2,
+                     sabai::SimdLevel::AVX2, sabai::SimdLevel::AVX512}) {
+    if (level <= sabai::detect_simd_level()) {
+      levels.push_back(level);
+    }
+  }
+  return levels;
+}
+
+std::string level_name(
+    const ::testing::TestParamInfo<sabai::SimdLevel> &info) {
+  switch (info.param) {
+  case sabai::SimdLevel::SSE2:
+    return "SSE2";
+  case sabai::SimdLevel::AVX2:
+    return "AVX2";
+  case sabai::SimdLevel::AVX512:
+    return "AVX512";
+  default:
+    return "Scalar";
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Levels, SimdFixture,
+                         ::testing::ValuesIn(supported_levels()), level_name);
@@ -2,6 +2,9 @@
 
 #include "gtest/gtest.h"
 
+#include <type_traits>
+#include <vector>
+
 class EmptyStaticArrayFixture : public ::testing::Test {
 protected:
   sabai::StaticVectori<2> vector2i;
@@ -122,7 +125,7 @@ TEST_F(ZeroStaticArrayFixture, AccessElement) {
 }
 
 TEST_F(ZeroStaticArrayFixture, AccessVectorElementOutOfRange) {
-  ASSERT_THROW(vector(2), sabai::OutOfRange);
+  ASSERT_THROW(vector.at(2), sabai::OutOfRange);
 }
 
 TEST_F(ZeroStaticArrayFixture, AccessLastElement) {
@@ -132,11 +135,11 @@ TEST_F(ZeroStaticArrayFixture, AccessLastElement) {
 }
 
 TEST_F(ZeroStaticArrayFixture, AccessMatrixElementOutOfRange) {
-  ASSERT_THROW(matrix(0, 2), sabai::OutOfRange);
+  ASSERT_THROW(matrix.at(0, 2), sabai::OutOfRange);
 }
 
 TEST_F(ZeroStaticArrayFixture, AccessMatrixRowOutOfRange) {
-  ASSERT_THROW(matrix(2), sabai::OutOfRange);
+  ASSERT_THROW(matrix.at(2), sabai::OutOfRange);
 }
 
 TEST_F(ZeroStaticArrayFixture, AccessElement2) {
@@ -170,7 +173,7 @@ TEST_F(MultiDimensional, AssignElement) {
 }
 
 TEST_F(MultiDimensional, AssignElementOutOfRange) {
-  ASSERT_THROW(matrix(2, 0) = 6, sabai::OutOfRange);
+  ASSERT_THROW(matrix.at(2, 0) = 6, sabai::OutOfRange);
 }
 
 TEST_F(MultiDimensional, AssignTensorElement) {
@@ -179,7 +182,7 @@ TEST_F(MultiDimensional, AssignTensorElement) {
 }
 
 TEST_F(MultiDimensional, AssignTemsorElementOutofRange) {
-  ASSERT_THROW(tensor(0, 2, 0) = 0, sabai::OutOfRange);
+  ASSERT_THROW(tensor.at(0, 2, 0) = 0, sabai::OutOfRange);
 }
 
 TEST_F(MultiDimensional, GetFirstTensorArray) {
@@ -208,6 +211,13 @@ TEST(Identity, Matrix) {
   ASSERT_TRUE(sabai::all_equal(matrix, answer));
 }
 
+TEST(All, Matrix) {
+  sabai::StaticArray<bool, 2, 3> matrix(true);
+  ASSERT_TRUE(sabai::all(matrix));
+  matrix(1, 2) = false;
+  ASSERT_FALSE(sabai::all(matrix));
+}
+
 TEST(ARange, Vector) {
   auto range = sabai::ARange<4>();
   sabai::StaticVector<size_t, 4> answer = {0, 1, 2, 3};
@@ -224,4 +234,69 @@ TEST_F(MultiDimensional, IndexingMatrix) {
   sabai::StaticVector<size_t, 1> indices = {1};
   sabai::StaticArrayi<1, 2> answer = {{3, 4}};
   ASSERT_TRUE(sabai::all_equal(answer, matrix(indices)));
-}
\ No newline at end of file
+}
+
+TEST_F(MultiDimensional, ConstRowIsReference) {
+  const auto &const_matrix = matrix;
+  ASSERT_EQ(const_matrix(1).data(), matrix(1).data());
+  ASSERT_EQ(&const_matrix(1, 0), &matrix(1, 0));
+}
+
+TEST_F(MultiDimensional, Column) {
+  auto column = matrix.column(1);
+  sabai::StaticVectori<2> answer = {2, 4};
+  ASSERT_TRUE(sabai::all_equal(column, answer));
+  column(1) = 0;
+  ASSERT_EQ(matrix(1, 1), 0);
+}
+
+TEST_F(MultiDimensional, ColumnOutOfRange) {
+  ASSERT_THROW(matrix.column(2), sabai::OutOfRange);
+}
+
+TEST(StaticArrayView, Block) {
+  sabai::StaticArrayi<3, 3> matrix = {{1, 2, 3}, {4, 5, 6}, {7, 8, 9}};
+  auto block = matrix.block<2, 2>(0, 1);
+  sabai::StaticArrayi<2, 2> answer = {{2, 3}, {5, 6}};
+  ASSERT_TRUE(sabai::all_equal(block, answer));
+  sabai::StaticArrayi<2, 2> copied = block;
+  ASSERT_TRUE(sabai::all_equal(copied, answer));
+  ASSERT_THROW((matrix.block<2, 2>(2, 0)), sabai::OutOfRange);
+}
+TEST_F(MultiDimensional, AtMatchesOperator) {
+  tensor.at(1, 0, 1) = 9;
+  ASSERT_EQ(tensor(1, 0, 1), 9);
+  ASSERT_TRUE(sabai::all_equal(tensor.at(1), tensor(1)));
+  ASSERT_EQ(matrix.column(1).at(1), 4);
+  ASSERT_THROW(matrix.column(1).at(2), sabai::OutOfRange);
+}
+
+TEST_F(MultiDimensional, OperatorChecksFollowPolicy) {
+  if constexpr (sabai::bounds_checked) {
+    ASSERT_THROW(matrix(2, 0), sabai::OutOfRange);
+    ASSERT_THROW(vector(2), sabai::OutOfRange);
+  } else {
+    ASSERT_NO_THROW(matrix(1, 1));
+  }
+}
+
+static_assert(std::is_trivially_copyable_v<sabai::StaticVectord<3>>);
+static_assert(std::is_trivially_copyable_v<sabai::StaticMatrixd<4, 4>>);
+static_assert(std::is_trivially_copyable_v<sabai::StaticArrayi<2, 3, 4>>);
+static_assert(sizeof(sabai::StaticArrayf<2, 3, 4>) == 24 * sizeof(float));
+
+TEST(TriviallyCopyable, CopiesAreIndependent) {
+  sabai::StaticMatrixd<3, 3> A = {
+      {1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}, {7.0, 8.0, 9.0}};
+  sabai::StaticMatrixd<3, 3> B = A;
+  std::vector<sabai::StaticMatrixd<3, 3>> copies(4, A);
+  A(1, 1) = 0.0;
+  ASSERT_EQ(B(1, 1), 5.0);
+  (B = A)(2, 2) = -1.0;
+  ASSERT_EQ(B(1, 1), 0.0);
+  ASSERT_EQ(B(2, 2), -1.0);
+  for (const auto &copy : copies) {
+    ASSERT_EQ(copy(1, 1), 5.0);
+    ASSERT_EQ(copy(2, 0), 7.0);
+  }
+}
@@ -0,0 +1,85 @@
+#include "sabai/task_graph.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+class TaskGraphFixture : public ::testing::Test {
+protected:
+  sabai::ThreadPool pool{4};
+};
+
+TEST_F(TaskGraphFixture, EmptyGraph) {
+  sabai::TaskGraph graph;
+  graph.run(pool);
+  ASSERT_EQ(graph.size(), 0);
+}
+
+TEST_F(TaskGraphFixture, ChainRunsInOrder) {
+  sabai::TaskGraph graph;
+  std::vector<size_t> order;
+  sabai::TaskGraph::TaskId previous = sabai::TaskGraph::none;
+  for (size_t task = 0; task < 20; ++task) {
+    previous = graph.add([&order, task] { order.push_back(task); },
+                         {previous});
+  }
+  graph.run(pool);
+  ASSERT_EQ(order.size(), 20);
+  for (size_t task = 0; task < order.size(); ++task) {
+    ASSERT_EQ(order[task], task);
+  }
+}
+
+TEST_F(TaskGraphFixture, DiamondWaitsForBothBranches) {
+  sabai::TaskGraph graph;
+  std::atomic<int> branches = 0;
+  int seen = -1;
+  const auto top = graph.add([] {}, {});
+  const auto left = graph.add([&] { ++branches; }, {top});
+  const auto right = graph.add([&] { ++branches; }, {top, top});
+  graph.add([&] { seen = branches; }, {left, right, sabai::TaskGraph::none});
+  graph.run(pool);
+  ASSERT_EQ(seen, 2);
+}
+
+TEST_F(TaskGraphFixture, RunsEveryTaskOnce) {
+  sabai::TaskGraph graph;
+  std::vector<std::atomic<int>> runs(500);
+  std::vector<sabai::TaskGraph::TaskId> ids;
+  for (size_t task = 0; task < runs.size(); ++task) {
+    const auto dependency =
+        task >= 3 ? ids[task - 3] : sabai::TaskGraph::none;
+    ids.push_back(graph.add([&runs, task] { ++runs[task]; }, {dependency}));
+  }
+  graph.run(pool);
+  for (const auto &count : runs) {
+    ASSERT_EQ(count, 1);
+  }
+}
+
+TEST_F(TaskGraphFixture, NestedParallelForRunsSerially) {
+  sabai::TaskGraph graph;
+  std::atomic<size_t> calls = 0;
+  for (size_t task = 0; task < 8; ++task) {
+    graph.add(
+        [&] {
+          pool.parallel_for(100, 1, [&](size_t, size_t) { ++calls; });
+        },
+        {});
+  }
+  graph.run(pool);
+  ASSERT_EQ(calls, 8);
+}
+
+TEST_F(TaskGraphFixture, PropagatesExceptions) {
+  sabai::TaskGraph graph;
+  bool after = false;
+  const auto failing =
+      graph.add([] { throw std::runtime_error("task failed"); }, {});
+  graph.add([&] { after = true; }, {failing});
+  ASSERT_THROW(graph.run(pool), std::runtime_error);
+  ASSERT_FALSE(after);
+}
@@ -0,0 +1,66 @@
+#include "sabai/thread_pool.hpp"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+class ThreadPoolFixture : public ::testing::Test {
+protected:
+  sabai::ThreadPool pool{4};
+};
+
+TEST_F(ThreadPoolFixture, Size) { ASSERT_EQ(pool.size(), 4); }
+
+TEST_F(ThreadPoolFixture, CoversEveryIndexOnce) {
+  std::vector<std::atomic<int>> visits(1000);
+  pool.parallel_for(visits.size(), 16, [&](size_t begin, size_t end) {
+    ASSERT_EQ(begin % 16, 0);
+    for (size_t index = begin; index < end; ++index) {
+      ++visits[index];
+    }
+  });
+  for (const auto &count : visits) {
+    ASSERT_EQ(count, 1);
+  }
+}
+
+TEST_F(ThreadPoolFixture, SmallRangeRunsAsOneChunk) {
+  size_t calls = 0;
+  pool.parallel_for(10, 16, [&](size_t begin, size_t end) {
+    ++calls;
+    ASSERT_EQ(begin, 0);
+    ASSERT_EQ(end, 10);
+  });
+  ASSERT_EQ(calls, 1);
+}
+
+TEST_F(ThreadPoolFixture, NestedParallelFor) {
+  std::atomic<size_t> total = 0;
+  pool.parallel_for(8, 1, [&](size_t begin, size_t end) {
+    for (size_t outer = begin; outer < end; ++outer) {
+      pool.parallel_for(8, 1, [&](size_t inner_begin, size_t inner_end) {
+        total += inner_end - inner_begin;
+      });
+    }
+  });
+  ASSERT_EQ(total, 64);
+}
+
+TEST_F(ThreadPoolFixture, RethrowsExceptions) {
+  ASSERT_THROW(pool.parallel_for(100, 1,
+                                 [](size_t begin, size_t) {
+                                   if (begin > 0) {
+                                     throw std::runtime_error("chunk");
+                                   }
+                                 }),
+               std::runtime_error);
+}
+
+TEST_F(ThreadPoolFixture, Resize) {
+  pool.resize(2);
+  ASSERT_EQ(pool.size(), 2);
+  pool.resize(0);
+  ASSERT_EQ(pool.size(), 1);
+}